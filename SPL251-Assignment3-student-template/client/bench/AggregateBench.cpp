@@ -0,0 +1,118 @@
+#include "Bench.h"
+#include "BenchData.h"
+#include "../include/EventStore.h"
+
+static const std::size_t AGGREGATE_EVENTS = 200000;
+static const int BUCKET_SECONDS = 3600;
+
+// The baseline is the layout the client used before the store: one std::vector<Event> per channel,
+// scanned event by event with a map lookup per flag
+struct EventVectors {
+    std::vector<Event> channel0;
+    EventStore store;
+
+    EventVectors() : channel0(), store() {
+        for (const Event &event : syntheticEvents(AGGREGATE_EVENTS)) {
+            if (event.get_channel_name() == "channel0")
+                channel0.push_back(event);
+            store.insert(event);
+        }
+        store.flush();
+    }
+};
+
+static const EventVectors &aggregateData() {
+    static const EventVectors data;
+    return data;
+}
+
+// Last week of one (channel, user) series, or of the whole channel when user is empty
+static SummaryQuery weekQuery(const std::string &user) {
+    SummaryQuery query;
+    query.channel = "channel0";
+    query.user = user;
+    query.hasFrom = true;
+    query.from = defaultShape().baseEpoch + (defaultShape().days - 7) * 86400;
+    return query;
+}
+
+static bool isFlagSet(const Event &event, const std::string &flag) {
+    const std::map<std::string, std::string> &info = event.get_general_information();
+    std::map<std::string, std::string>::const_iterator it = info.find(flag);
+    return it != info.end() && it->second == "true";
+}
+
+static bool vectorMatches(const Event &event, const SummaryQuery &query) {
+    return event.get_date_time() >= query.from && (query.user.empty() || event.getEventOwnerUser() == query.user);
+}
+
+static SummaryCounts vectorCounts(const std::vector<Event> &events, const SummaryQuery &query) {
+    SummaryCounts counts;
+    for (const Event &event : events) {
+        if (!vectorMatches(event, query))
+            continue;
+        ++counts.total;
+        counts.active += isFlagSet(event, "active");
+        counts.forcesArrivalAtScene += isFlagSet(event, "forces_arrival_at_scene");
+    }
+    return counts;
+}
+
+static void runVectorCounts(const std::string &user, std::size_t iterations) {
+    const EventVectors &data = aggregateData();
+    SummaryQuery query = weekQuery(user);
+    for (std::size_t i = 0; i < iterations; ++i)
+        doNotOptimize(vectorCounts(data.channel0, query).active);
+}
+
+static void runColumnCounts(const std::string &user, std::size_t iterations) {
+    EventStore::Snapshot snapshot = aggregateData().store.snapshot();
+    SummaryQuery query = weekQuery(user);
+    for (std::size_t i = 0; i < iterations; ++i)
+        doNotOptimize(snapshot.aggregate(query).active);
+}
+
+BENCH(aggregate_series_counts_event_vector) {
+    runVectorCounts("user0", iterations);
+}
+
+BENCH(aggregate_series_counts_columns) {
+    runColumnCounts("user0", iterations);
+}
+
+BENCH(aggregate_channel_counts_event_vector) {
+    runVectorCounts("", iterations);
+}
+
+BENCH(aggregate_channel_counts_columns) {
+    runColumnCounts("", iterations);
+}
+
+BENCH(aggregate_channel_histogram_event_vector) {
+    const EventVectors &data = aggregateData();
+    SummaryQuery query = weekQuery("");
+    for (std::size_t i = 0; i < iterations; ++i) {
+        std::vector<SummaryCounts> buckets(7 * 86400 / BUCKET_SECONDS + 1);
+        for (const Event &event : data.channel0) {
+            if (!vectorMatches(event, query))
+                continue;
+            SummaryCounts &counts = buckets[(event.get_date_time() - query.from) / BUCKET_SECONDS];
+            ++counts.total;
+            counts.active += isFlagSet(event, "active");
+            counts.forcesArrivalAtScene += isFlagSet(event, "forces_arrival_at_scene");
+        }
+        doNotOptimize(buckets.data());
+    }
+}
+
+BENCH(aggregate_channel_histogram_columns) {
+    EventStore::Snapshot snapshot = aggregateData().store.snapshot();
+    SummaryQuery query = weekQuery("");
+    std::vector<EventStore::Snapshot::HistogramBucket> buckets;
+    for (std::size_t i = 0; i < iterations; ++i) {
+        snapshot.histogram(query, BUCKET_SECONDS, buckets);
+        doNotOptimize(buckets.data());
+    }
+    if (iterations != 0)
+        benchReport("index_and_column_bytes_per_event", double(aggregateData().store.indexMemoryBytes()) / AGGREGATE_EVENTS, "B");
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <vector>
+
+// Minimal microbenchmark harness. A benchmark body receives an iteration count and must run its
+// operation exactly that many times; BenchMain calibrates the count and reports the cost per operation.
+// Each body is first called once with zero iterations, untimed, so static fixtures can be built lazily.
+struct BenchCase {
+    std::string name;
+    std::function<void(std::size_t)> body;
+};
+
+std::vector<BenchCase> &benchRegistry();
+
+// Extra measurements (memory, rates...) a benchmark wants printed next to its timing
+void benchReport(const std::string &name, double value, const std::string &unit);
+
+struct BenchRegistrar {
+    BenchRegistrar(const std::string &name, const std::function<void(std::size_t)> &body) {
+        BenchCase benchCase = {name, body};
+        benchRegistry().push_back(benchCase);
+    }
+};
+
+// Keeps the compiler from optimizing away a value computed inside a benchmark loop
+template <class T>
+inline void doNotOptimize(const T &value) {
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+#define BENCH(name)                                                          \
+    static void name(std::size_t iterations);                                \
+    static BenchRegistrar name##_registrar(#name, name);                      \
+    static void name(std::size_t iterations)
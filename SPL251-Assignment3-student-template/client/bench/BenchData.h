@@ -0,0 +1,59 @@
+#pragma once
+
+#include <random>
+#include <string>
+#include <vector>
+#include "../include/event.h"
+
+// Deterministic synthetic reports shared by the benchmarks
+struct SyntheticShape {
+    int channels;
+    int users;
+    int cities;
+    int names;
+    int days;       // date_time spread
+    int baseEpoch;
+};
+
+inline SyntheticShape defaultShape() {
+    SyntheticShape shape = {2, 4, 200, 20, 30, 1734961200};
+    return shape;
+}
+
+inline std::vector<Event> syntheticEvents(std::size_t count, const SyntheticShape &shape = defaultShape(),
+                                          unsigned seed = 7) {
+    static const char *words[] = {"black", "SUV", "suspect", "fled", "scene", "north", "on", "foot", "red",
+                                  "sedan", "injured", "victim", "store", "armed", "masked", "street"};
+    std::mt19937 rng(seed);
+    std::uniform_int_distribution<int> channel(0, shape.channels - 1), user(0, shape.users - 1);
+    std::uniform_int_distribution<int> city(0, shape.cities - 1), name(0, shape.names - 1);
+    std::uniform_int_distribution<int> offset(0, shape.days * 86400 - 1), coin(0, 1), word(0, 15);
+
+    std::vector<Event> events;
+    events.reserve(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        std::map<std::string, std::string> info;
+        info["active"] = coin(rng) ? "true" : "false";
+        info["forces_arrival_at_scene"] = coin(rng) ? "true" : "false";
+        std::string description;
+        for (int w = 0; w < 16; ++w) {
+            if (w) description += ' ';
+            description += words[word(rng)];
+        }
+        Event event("channel" + std::to_string(channel(rng)), "City " + std::to_string(city(rng)),
+                    "Event " + std::to_string(name(rng)), shape.baseEpoch + offset(rng), description, info);
+        event.setEventOwnerUser("user" + std::to_string(user(rng)));
+        events.push_back(event);
+    }
+    return events;
+}
+
+// The MESSAGE body the server sends for an event, as the reader thread decodes it
+inline std::string messageBody(const Event &event) {
+    std::string body = "user: " + event.getEventOwnerUser() + "\nchannel name: " + event.get_channel_name() +
+                       "\ncity: " + event.get_city() + "\nevent name: " + event.get_name() +
+                       "\ndate time: " + std::to_string(event.get_date_time()) + "\ngeneral information:\n";
+    for (const auto &info : event.get_general_information())
+        body += "  " + info.first + ": " + info.second + "\n";
+    return body + "description: " + event.get_description() + "\n";
+}
@@ -0,0 +1,134 @@
+#include "Bench.h"
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <unistd.h>
+
+std::vector<BenchCase> &benchRegistry() {
+    static std::vector<BenchCase> registry;
+    return registry;
+}
+
+struct BenchMetric {
+    std::string name;
+    double value;
+    std::string unit;
+};
+
+static std::vector<BenchMetric> &pendingMetrics() {
+    static std::vector<BenchMetric> metrics;
+    return metrics;
+}
+
+void benchReport(const std::string &name, double value, const std::string &unit) {
+    // Benchmarks run several times while calibrating; keep only the latest value per name
+    for (BenchMetric &metric : pendingMetrics()) {
+        if (metric.name == name) {
+            metric.value = value;
+            metric.unit = unit;
+            return;
+        }
+    }
+    BenchMetric metric = {name, value, unit};
+    pendingMetrics().push_back(metric);
+}
+
+struct BenchResult {
+    std::string name;
+    std::size_t iterations;
+    double nanosPerOp;
+    std::vector<BenchMetric> metrics;
+};
+
+static std::string jsonString(const std::string &text) {
+    std::string quoted = "\"";
+    for (char c : text) {
+        if (c == '"' || c == '\\')
+            quoted += '\\';
+        if (static_cast<unsigned char>(c) >= 0x20)
+            quoted += c;
+    }
+    return quoted + "\"";
+}
+
+// One object: when and where the run happened, then every result. Names are stable across releases, so
+// two files can be compared benchmark by benchmark.
+static bool writeJson(const std::string &path, const std::vector<BenchResult> &results) {
+    char date[32], host[256] = "";
+    std::time_t now = std::time(nullptr);
+    std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%SZ", std::gmtime(&now));
+    gethostname(host, sizeof(host) - 1);
+
+    std::ofstream out(path.c_str(), std::ios::trunc);
+    out << "{\n  \"context\": {\"date\": " << jsonString(date) << ", \"host\": " << jsonString(host)
+        << ", \"compiler\": " << jsonString(__VERSION__) << "},\n  \"benchmarks\": [";
+    for (std::size_t i = 0; i < results.size(); ++i) {
+        const BenchResult &result = results[i];
+        char nanos[32];
+        std::snprintf(nanos, sizeof(nanos), "%.3f", result.nanosPerOp);
+        out << (i ? "," : "") << "\n    {\"name\": " << jsonString(result.name) << ", \"iterations\": "
+            << result.iterations << ", \"ns_per_op\": " << nanos << ", \"metrics\": {";
+        for (std::size_t m = 0; m < result.metrics.size(); ++m) {
+            char value[32];
+            std::snprintf(value, sizeof(value), "%.6g", result.metrics[m].value);
+            out << (m ? ", " : "") << jsonString(result.metrics[m].name) << ": {\"value\": " << value
+                << ", \"unit\": " << jsonString(result.metrics[m].unit) << "}";
+        }
+        out << "}}";
+    }
+    out << "\n  ]\n}\n";
+    return static_cast<bool>(out.flush());
+}
+
+static double runOnce(const BenchCase &benchCase, std::size_t iterations) {
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    benchCase.body(iterations);
+    std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(end - start).count();
+}
+
+// Usage: StompBench [--json <file>] [name-filter]
+int main(int argc, char *argv[]) {
+    const char *filter = nullptr;
+    std::string jsonPath;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--json") == 0 && i + 1 < argc)
+            jsonPath = argv[++i];
+        else
+            filter = argv[i];
+    }
+    const double targetNanos = 2e8; // aim for ~0.2s per benchmark
+    std::vector<BenchResult> results;
+
+    std::printf("%-40s %14s %14s\n", "benchmark", "iterations", "ns/op");
+    for (const BenchCase &benchCase : benchRegistry()) {
+        if (filter != nullptr && std::strstr(benchCase.name.c_str(), filter) == nullptr)
+            continue;
+
+        benchCase.body(0); // untimed warm up, lets a benchmark build its fixtures
+
+        // Grow the iteration count until one run takes long enough to time reliably
+        std::size_t iterations = 1;
+        double nanos = runOnce(benchCase, iterations);
+        while (nanos < targetNanos && iterations < (std::size_t(1) << 40)) {
+            double scale = nanos > 0 ? targetNanos / nanos : 100.0;
+            if (scale > 100.0) scale = 100.0;
+            if (scale < 2.0) scale = 2.0;
+            iterations = static_cast<std::size_t>(iterations * scale);
+            nanos = runOnce(benchCase, iterations);
+        }
+        std::printf("%-40s %14zu %14.2f\n", benchCase.name.c_str(), iterations, nanos / iterations);
+        for (const BenchMetric &metric : pendingMetrics())
+            std::printf("    %-36s %14.2f %s\n", metric.name.c_str(), metric.value, metric.unit.c_str());
+        BenchResult result = {benchCase.name, iterations, nanos / iterations, pendingMetrics()};
+        results.push_back(result);
+        pendingMetrics().clear();
+    }
+    if (!jsonPath.empty() && !writeJson(jsonPath, results)) {
+        std::fprintf(stderr, "Cannot write %s\n", jsonPath.c_str());
+        return 1;
+    }
+    return 0;
+}
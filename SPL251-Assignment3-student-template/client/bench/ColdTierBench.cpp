@@ -0,0 +1,80 @@
+#include "Bench.h"
+#include "BenchData.h"
+#include "../include/ColdBlock.h"
+#include "../include/EventStore.h"
+#include "../include/SummaryWriter.h"
+
+static const std::size_t TIER_EVENTS = 100000;
+
+// The synthetic reports are all from December 2024, so any positive age sends every sealed block cold
+static EventStore &tierStore(bool cold) {
+    static EventStore hot;
+    static EventStore packed([] {
+        EventStoreOptions options;
+        options.coldAfterSeconds = 24 * 3600;
+        return options;
+    }());
+    EventStore &store = cold ? packed : hot;
+    if (store.snapshot().size() == 0) {
+        for (const Event &event : syntheticEvents(TIER_EVENTS))
+            store.insert(event);
+        store.flush();
+    }
+    return store;
+}
+
+static const EventBlock &fullBlock() {
+    static EventBlock block;
+    if (block.count() == 0) {
+        for (const Event &event : syntheticEvents(EventBlock::CAPACITY))
+            block.append(event);
+    }
+    return block;
+}
+
+// A full text summary of one (channel, user) series: about 1/8 of the events, spread over every block.
+// Each iteration takes a new snapshot, so on the cold tier every block it reads is inflated again.
+static void runSummary(bool cold, std::size_t iterations) {
+    EventStore &store = tierStore(cold);
+    SummaryQuery query;
+    query.channel = "channel0";
+    query.user = "user0";
+    query.file = "/tmp/stomp-bench-tier-summary.txt";
+    for (std::size_t i = 0; i < iterations; ++i) {
+        EventStore::Snapshot snapshot = store.snapshot();
+        std::vector<EventId> ids = snapshot.select(query);
+        std::vector<const Event *> events;
+        events.reserve(ids.size());
+        for (EventId id : ids)
+            events.push_back(&snapshot.get(id));
+        doNotOptimize(writeSummary(query, events, snapshot.aggregate(query)));
+    }
+    if (iterations != 0) {
+        std::size_t hot, packed;
+        store.eventMemoryBytes(hot, packed);
+        benchReport("event_memory_per_million", double(hot + packed) / TIER_EVENTS * 1e6 / (1 << 20), "MiB");
+    }
+}
+
+BENCH(cold_tier_summary_hot) {
+    runSummary(false, iterations);
+}
+
+BENCH(cold_tier_summary_cold) {
+    runSummary(true, iterations);
+}
+
+BENCH(cold_tier_compress_block) {
+    const EventBlock &block = fullBlock();
+    std::size_t packedBytes = 0;
+    for (std::size_t i = 0; i < iterations; ++i)
+        packedBytes = ColdBlock::compress(block)->memoryBytes();
+    if (iterations != 0)
+        benchReport("bytes_per_event", double(packedBytes) / EventBlock::CAPACITY, "B");
+}
+
+BENCH(cold_tier_inflate_block) {
+    std::shared_ptr<const ColdBlock> packed = ColdBlock::compress(fullBlock());
+    for (std::size_t i = 0; i < iterations; ++i)
+        doNotOptimize(packed->inflate()->count());
+}
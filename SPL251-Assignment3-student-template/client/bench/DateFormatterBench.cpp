@@ -0,0 +1,70 @@
+#include "Bench.h"
+#include "../include/DateFormatter.h"
+#include <ctime>
+#include <iomanip>
+#include <random>
+#include <sstream>
+
+// The formatter epochToDate used before DateFormatter, kept as the baseline
+static std::string legacyEpochToDate(int epoch) {
+    std::time_t time = epoch;
+    std::tm tm = *std::localtime(&time);
+    std::ostringstream oss;
+    oss << std::put_time(&tm, "%d/%m/%y %H:%M");
+    return oss.str();
+}
+
+static const int BASE_EPOCH = 1734961200; // 23/12/24, same range as the sample events
+
+static std::vector<int> randomEpochs() {
+    std::vector<int> epochs(4096);
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<int> offset(0, 3 * 365 * 24 * 3600);
+    for (int &epoch : epochs)
+        epoch = BASE_EPOCH + offset(rng);
+    return epochs;
+}
+
+// Summary order: increasing times a few minutes apart
+BENCH(date_legacy_sequential) {
+    for (std::size_t i = 0; i < iterations; ++i)
+        doNotOptimize(legacyEpochToDate(BASE_EPOCH + static_cast<int>(i % 100000) * 97));
+}
+
+BENCH(date_formatter_sequential) {
+    char out[DateFormatter::DATE_LENGTH];
+    for (std::size_t i = 0; i < iterations; ++i) {
+        DateFormatter::format(BASE_EPOCH + static_cast<int>(i % 100000) * 97, out);
+        doNotOptimize(out);
+    }
+}
+
+// Every call hits the cached hour, the steady state cost of a formatted date
+BENCH(date_formatter_same_hour) {
+    char out[DateFormatter::DATE_LENGTH];
+    for (std::size_t i = 0; i < iterations; ++i) {
+        DateFormatter::format(BASE_EPOCH + static_cast<int>(i % 3600), out);
+        doNotOptimize(out);
+    }
+}
+
+// Times spread over three years, so most lookups miss the per-thread hour cache
+BENCH(date_legacy_random) {
+    static const std::vector<int> epochs = randomEpochs();
+    for (std::size_t i = 0; i < iterations; ++i)
+        doNotOptimize(legacyEpochToDate(epochs[i & 4095]));
+}
+
+BENCH(date_formatter_random) {
+    static const std::vector<int> epochs = randomEpochs();
+    char out[DateFormatter::DATE_LENGTH];
+    for (std::size_t i = 0; i < iterations; ++i) {
+        DateFormatter::format(epochs[i & 4095], out);
+        doNotOptimize(out);
+    }
+}
+
+BENCH(date_formatter_string) {
+    for (std::size_t i = 0; i < iterations; ++i)
+        doNotOptimize(DateFormatter::format(BASE_EPOCH + static_cast<int>(i % 100000) * 97));
+}
@@ -0,0 +1,61 @@
+#include "Bench.h"
+#include "BenchData.h"
+#include "../include/Deduplicator.h"
+#include "../include/Hash.h"
+
+static const std::vector<Event> &dedupeEvents() {
+    static const std::vector<Event> events = syntheticEvents(100000);
+    return events;
+}
+
+// Decoding includes the content hash; the difference between the two is its cost
+BENCH(dedupe_decode_event) {
+    static const std::string body = messageBody(dedupeEvents()[0]);
+    for (std::size_t i = 0; i < iterations; ++i)
+        doNotOptimize(Event(body).get_content_hash());
+}
+
+BENCH(dedupe_content_hash) {
+    Event event = dedupeEvents()[0];
+    for (std::size_t i = 0; i < iterations; ++i) {
+        event.setEventOwnerUser(i % 2 ? "user0" : "user1"); // recomputes the hash
+        doNotOptimize(event.get_content_hash());
+    }
+}
+
+BENCH(dedupe_first_seen_new) {
+    Deduplicator deduplicator;
+    for (std::size_t i = 0; i < iterations; ++i)
+        doNotOptimize(deduplicator.firstSeen(mix64(i)));
+    benchReport("memory", double(deduplicator.memoryBytes()) / (1 << 20), "MiB");
+}
+
+// A resent report file: every hash is still in the exact set
+BENCH(dedupe_first_seen_recent_duplicate) {
+    static Deduplicator deduplicator;
+    const std::size_t distinct = 10000;
+    if (iterations == 0) {
+        for (std::size_t i = 0; i < distinct; ++i)
+            deduplicator.firstSeen(mix64(i));
+    }
+    for (std::size_t i = 0; i < iterations; ++i)
+        doNotOptimize(deduplicator.firstSeen(mix64(i % distinct)));
+}
+
+// New events wrongly taken for duplicates once the history is full: the exact set has forgotten
+// most hashes, both Bloom generations are full, and none of the probes were ever added
+BENCH(dedupe_false_positive_rate) {
+    static Deduplicator deduplicator;
+    static std::uint64_t next = 0;
+    if (iterations == 0) {
+        for (; next < 2 * Deduplicator::DEFAULT_GENERATION - 1; ++next)
+            deduplicator.firstSeen(mix64(next));
+        return;
+    }
+    std::size_t falsePositives = 0;
+    const std::uint64_t probes = std::uint64_t(1) << 40; // far from the hashed history values
+    for (std::size_t i = 0; i < iterations; ++i)
+        falsePositives += deduplicator.seen(mix64(probes + i)) ? 1 : 0;
+    if (iterations >= 100000)
+        benchReport("false_positive_rate", 100.0 * falsePositives / iterations, "%");
+}
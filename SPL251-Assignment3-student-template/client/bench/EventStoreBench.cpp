@@ -0,0 +1,198 @@
+#include "Bench.h"
+#include "BenchData.h"
+#include "../include/EventStore.h"
+#include "../include/Metrics.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+static const std::size_t STORE_EVENTS = 200000;
+
+static EventStoreOptions noIndexes() {
+    EventStoreOptions options;
+    options.indexCity = false;
+    options.indexEventName = false;
+    options.indexedInfoKeys.clear();
+    return options;
+}
+
+static const std::vector<Event> &storeEvents() {
+    static const std::vector<Event> events = syntheticEvents(STORE_EVENTS);
+    return events;
+}
+
+static EventStore &filledStore(bool indexed) {
+    static EventStore plain(noIndexes());
+    static EventStore withIndexes;
+    EventStore &store = indexed ? withIndexes : plain;
+    if (store.snapshot().size() == 0) {
+        for (const Event &event : storeEvents())
+            store.insert(event);
+        store.flush();
+    }
+    return store;
+}
+
+// Last two days of one city in one (channel, user) series, the shape of an interactive analyst query
+static SummaryQuery cityQuery() {
+    SummaryQuery query;
+    query.channel = "channel0";
+    query.user = "user0";
+    query.hasFrom = true;
+    query.from = defaultShape().baseEpoch + (defaultShape().days - 2) * 86400;
+    query.city = "City 17";
+    return query;
+}
+
+static void runSelect(bool indexed, std::size_t iterations) {
+    EventStore::Snapshot snapshot = filledStore(indexed).snapshot();
+    SummaryQuery query = cityQuery();
+    query.infoKey = "active";
+    query.infoValue = "true";
+    for (std::size_t i = 0; i < iterations; ++i)
+        doNotOptimize(snapshot.select(query));
+}
+
+BENCH(store_select_city_scan) {
+    runSelect(false, iterations);
+}
+
+BENCH(store_select_city_indexed) {
+    runSelect(true, iterations);
+    benchReport("index_bytes_per_event", double(filledStore(true).indexMemoryBytes()) / STORE_EVENTS, "B");
+}
+
+static void runInsert(const EventStoreOptions &options, std::size_t iterations) {
+    const std::vector<Event> &events = storeEvents();
+    EventStore store(options);
+    for (std::size_t i = 0; i < iterations; ++i)
+        store.insert(events[i % events.size()]);
+    doNotOptimize(store.snapshot().size());
+}
+
+BENCH(store_insert_no_indexes) {
+    runInsert(noIndexes(), iterations);
+}
+
+BENCH(store_insert_indexed) {
+    runInsert(EventStoreOptions(), iterations);
+}
+
+static const std::size_t LATENCY_EVENTS = 2000000;
+
+// One iteration ingests LATENCY_EVENTS reports into a fresh store and times every insert. A block seal
+// should cost about as much as an append, so the tail stays close to the median.
+static void runInsertLatency(const EventStoreOptions &options, std::size_t iterations) {
+    const std::vector<Event> &events = storeEvents();
+    for (std::size_t run = 0; run < iterations; ++run) {
+        MetricsRegistry::HistogramSnapshot latency;
+        EventStore store(options);
+        for (std::size_t i = 0; i < LATENCY_EVENTS; ++i) {
+            std::chrono::steady_clock::time_point before = std::chrono::steady_clock::now();
+            store.insert(events[i % events.size()]);
+            latency.add(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - before)
+                            .count());
+        }
+        benchReport("insert_p50", latency.percentile(0.5) / 1000.0, "us");
+        benchReport("insert_p99", latency.percentile(0.99) / 1000.0, "us");
+        benchReport("insert_p99.99", latency.percentile(0.9999) / 1000.0, "us");
+        benchReport("insert_max", latency.max() / 1000.0, "us");
+    }
+}
+
+BENCH(store_insert_latency) {
+    runInsertLatency(EventStoreOptions(), iterations);
+}
+
+// The synthetic reports are from December 2024, so every block is packed once indexed
+BENCH(store_insert_latency_cold_tier) {
+    EventStoreOptions options;
+    options.coldAfterSeconds = 24 * 3600;
+    runInsertLatency(options, iterations);
+}
+
+// Ingestion while summary threads keep querying the same store. The baseline is the previous design:
+// one mutex around the store, held by a summary for its whole select and copy of the events.
+struct LockedStore {
+    std::mutex mutex;
+    EventStore store;
+
+    LockedStore() : mutex(), store() {}
+};
+
+static const int SUMMARY_THREADS = 2;
+
+template <class Insert, class Summary>
+static void runIngestUnderLoad(std::size_t iterations, Insert insert, Summary summary) {
+    const std::vector<Event> &events = storeEvents();
+    std::atomic<bool> done(false);
+    std::atomic<std::size_t> summaries(0);
+    std::vector<std::thread> readers;
+    for (int t = 0; t < SUMMARY_THREADS; ++t) {
+        readers.push_back(std::thread([&]() {
+            while (!done.load(std::memory_order_relaxed)) {
+                summary();
+                summaries.fetch_add(1, std::memory_order_relaxed);
+            }
+        }));
+    }
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    double worstNanos = 0;
+    for (std::size_t i = 0; i < iterations; ++i) {
+        std::chrono::steady_clock::time_point before = std::chrono::steady_clock::now();
+        insert(events[i % events.size()]);
+        double nanos = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - before).count();
+        worstNanos = std::max(worstNanos, nanos);
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    done = true;
+    for (std::thread &reader : readers)
+        reader.join();
+    if (iterations != 0) {
+        benchReport("summaries_per_second", summaries / seconds, "1/s");
+        benchReport("worst_insert", worstNanos / 1000, "us");
+    }
+}
+
+// The last two days of one series: a few thousand events copied out per summary
+static SummaryQuery seriesQuery() {
+    SummaryQuery query = cityQuery();
+    query.city.clear();
+    return query;
+}
+
+BENCH(store_ingest_under_summaries_snapshot) {
+    static EventStore &store = filledStore(true);
+    runIngestUnderLoad(iterations,
+        [](const Event &event) { store.insert(event); },
+        []() {
+            EventStore::Snapshot snapshot = store.snapshot();
+            std::vector<Event> copied;
+            for (EventId id : snapshot.select(seriesQuery()))
+                copied.push_back(snapshot.get(id));
+            doNotOptimize(copied.size());
+        });
+}
+
+BENCH(store_ingest_under_summaries_locked) {
+    static LockedStore locked;
+    if (locked.store.snapshot().size() == 0) {
+        for (const Event &event : storeEvents())
+            locked.store.insert(event);
+    }
+    runIngestUnderLoad(iterations,
+        [](const Event &event) {
+            std::lock_guard<std::mutex> lock(locked.mutex);
+            locked.store.insert(event);
+        },
+        []() {
+            std::lock_guard<std::mutex> lock(locked.mutex);
+            EventStore::Snapshot snapshot = locked.store.snapshot();
+            std::vector<Event> copied;
+            for (EventId id : snapshot.select(seriesQuery()))
+                copied.push_back(snapshot.get(id));
+            doNotOptimize(copied.size());
+        });
+}
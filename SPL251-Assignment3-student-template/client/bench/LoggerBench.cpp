@@ -0,0 +1,44 @@
+#include "Bench.h"
+#include "../include/Logger.h"
+#include <fstream>
+
+// The cost on the logging thread of one "Server MESSAGE" line, into /dev/null so only the logging
+// machinery is measured (a terminal makes every flush a slow write)
+static const std::string &frameText() {
+    static const std::string text =
+        "Server MESSAGE: MESSAGE\nsubscription:1\nmessage-id:42\ndestination:police\n\nuser: alice\n"
+        "channel name: police\ncity: Raccoon City\nevent name: Armed Robbery\ndate time: 1735689600\n"
+        "general information:\n  active: true\n  forces_arrival_at_scene: false\ndescription: black SUV fled";
+    return text;
+}
+
+// Before: the reader wrote each frame itself, under the output mutex, with std::endl
+BENCH(log_direct_endl) {
+    static std::ofstream out("/dev/null");
+    static std::mutex mutex;
+    for (std::size_t i = 0; i < iterations; ++i) {
+        std::lock_guard<std::mutex> lock(mutex);
+        out << frameText() << std::endl;
+    }
+}
+
+BENCH(log_async) {
+    static std::ofstream out("/dev/null");
+    static Logger *logger = nullptr;
+    if (logger == nullptr) {
+        logger = new Logger(); // outlives the benchmarks; its writer thread runs until exit
+        logger->addSink(&out, LogFormat::Plain, LogLevel::Debug);
+    }
+    for (std::size_t i = 0; i < iterations; ++i)
+        logger->log(LogLevel::Info, LogCategory::Frame, frameText());
+    logger->flush(); // includes the writer's share, which on one core competes with the caller
+
+}
+
+// A category turned off: the level check alone, the message is never built
+BENCH(log_disabled) {
+    static Logger logger;
+    logger.setLevel(LogCategory::Frame, LogLevel::Off);
+    for (std::size_t i = 0; i < iterations; ++i)
+        STOMP_LOG(logger, LogLevel::Info, LogCategory::Frame, frameText() << i);
+}
@@ -0,0 +1,90 @@
+#include "Bench.h"
+#include "BenchData.h"
+#include "../include/Deduplicator.h"
+#include "../include/EventStore.h"
+#include "../include/KeyedThreadPool.h"
+#include <algorithm>
+#include <chrono>
+
+// MESSAGE frames over 8 channels, as the reader thread reads them
+static const std::vector<std::string> &messageFrames() {
+    static std::vector<std::string> frames;
+    if (frames.empty()) {
+        SyntheticShape shape = defaultShape();
+        shape.channels = 8;
+        for (const Event &event : syntheticEvents(100000, shape)) {
+            std::string frame = "MESSAGE\nsubscription:1\nmessage-id:1\ndestination:" + event.get_channel_name() +
+                                "\n\nuser: " + event.getEventOwnerUser() + "\nchannel name: " +
+                                event.get_channel_name() + "\ncity: " + event.get_city() + "\nevent name: " +
+                                event.get_name() + "\ndate time: " + std::to_string(event.get_date_time()) +
+                                "\ngeneral information:\n";
+            for (const auto &info : event.get_general_information())
+                frame += "  " + info.first + ": " + info.second + "\n";
+            frames.push_back(frame + "description: " + event.get_description() + "\n");
+        }
+    }
+    return frames;
+}
+
+static void ingest(const std::string &frame, Deduplicator &deduplicator, EventStore &store) {
+    Event event(frame.substr(frame.find("\n\n") + 2));
+    if (deduplicator.firstSeen(event.get_content_hash()))
+        store.insert(event);
+}
+
+static std::string destination(const std::string &frame) {
+    std::size_t pos = frame.find("\ndestination:") + 13;
+    return frame.substr(pos, frame.find('\n', pos) - pos);
+}
+
+// Before: the reader decodes and stores every frame itself
+BENCH(message_ingest_inline) {
+    const std::vector<std::string> &frames = messageFrames();
+    Deduplicator deduplicator;
+    EventStore store;
+    for (std::size_t i = 0; i < iterations; ++i)
+        ingest(frames[i % frames.size()], deduplicator, store);
+}
+
+// A burst read in one wakeup, 64 frames at a time: the deduplicator is locked once per burst and each
+// store shard once per run of frames on it (the first 100000 frames are all new, as inline)
+BENCH(message_ingest_batched) {
+    const std::vector<std::string> &frames = messageFrames();
+    Deduplicator deduplicator;
+    EventStore store;
+    std::vector<Event> events;
+    std::vector<std::uint64_t> hashes;
+    std::vector<bool> fresh;
+    for (std::size_t done = 0; done < iterations;) {
+        std::size_t batch = std::min<std::size_t>(64, iterations - done);
+        events.clear();
+        hashes.clear();
+        for (std::size_t i = 0; i < batch; ++i) {
+            const std::string &frame = frames[(done + i) % frames.size()];
+            events.push_back(Event(frame.substr(frame.find("\n\n") + 2)));
+            hashes.push_back(events.back().get_content_hash());
+        }
+        deduplicator.firstSeen(hashes, fresh);
+        store.insert(events);
+        done += batch;
+    }
+}
+
+// After: the reader hands each frame to its channel's worker; reader_ns is what is left on the reader,
+// including waits for room once the bounded queues fill up (the workers fall behind on one CPU)
+BENCH(message_ingest_workers) {
+    const std::vector<std::string> &frames = messageFrames();
+    Deduplicator deduplicator;
+    EventStore store;
+    KeyedThreadPool workers(4);
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (std::size_t i = 0; i < iterations; ++i) {
+        const std::string &frame = frames[i % frames.size()];
+        workers.submit(std::hash<std::string>()(destination(frame)),
+                       [&deduplicator, &store, frame]() { ingest(frame, deduplicator, store); });
+    }
+    double handOff = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    workers.wait();
+    if (iterations > 0)
+        benchReport("reader_ns", handOff / iterations, "ns/frame");
+}
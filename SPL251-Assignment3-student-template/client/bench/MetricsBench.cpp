@@ -0,0 +1,44 @@
+#include "Bench.h"
+#include "../include/Metrics.h"
+#include <atomic>
+
+// Per-update cost of the metrics on the hot paths. The shared atomic is what a plain global counter
+// would cost uncontended; with several threads updating it, its cache line bounces between cores.
+
+static MetricsRegistry &benchMetrics()
+{
+    static MetricsRegistry registry;
+    return registry;
+}
+
+BENCH(metrics_shared_atomic_add) {
+    static std::atomic<std::uint64_t> counter(0);
+    for (std::size_t i = 0; i < iterations; ++i)
+        counter.fetch_add(1, std::memory_order_relaxed);
+    doNotOptimize(counter);
+}
+
+BENCH(metrics_counter_add) {
+    static MetricsRegistry::Counter counter = benchMetrics().counter("bench_counter_total", "Bench.");
+    for (std::size_t i = 0; i < iterations; ++i)
+        counter.add();
+}
+
+BENCH(metrics_histogram_record) {
+    static MetricsRegistry::Histogram histogram = benchMetrics().histogram("bench_seconds", "Bench.");
+    for (std::size_t i = 0; i < iterations; ++i)
+        histogram.record(1000 + (i & 0xffff) * 37);
+    if (iterations > 0) {
+        MetricsRegistry::HistogramSnapshot snapshot = benchMetrics().snapshot(histogram);
+        benchReport("p99", snapshot.percentile(0.99) / 1e3, "us");
+    }
+}
+
+// A timed section: two clock reads and the record
+BENCH(metrics_timed_section) {
+    static MetricsRegistry::Histogram histogram = benchMetrics().histogram("bench_section_seconds", "Bench.");
+    for (std::size_t i = 0; i < iterations; ++i) {
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        histogram.record(elapsedNanoseconds(start));
+    }
+}
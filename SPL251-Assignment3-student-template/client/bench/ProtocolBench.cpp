@@ -0,0 +1,108 @@
+#include "Bench.h"
+#include "BenchData.h"
+#include "../include/ConnectionHandler.h"
+#include "../include/StompProtocol.h"
+#include <cstdio>
+#include <fstream>
+
+// The client's per-frame hot paths without a server: building frames, splitting the received bytes into
+// frames (fed from memory, not a socket) and parsing a report file
+
+static const std::size_t FRAMES_PER_FEED = 256;
+
+static const std::vector<Event> &protocolEvents() {
+    static const std::vector<Event> events = syntheticEvents(FRAMES_PER_FEED);
+    return events;
+}
+
+static StompProtocol &benchProtocol() {
+    static ConnectionHandler handler("127.0.0.1", 0); // never connected
+    static StompProtocol protocol(handler);
+    return protocol;
+}
+
+// MESSAGE frames as the server sends them, '\0' terminated
+static const std::string &messageFrames() {
+    static std::string frames;
+    if (frames.empty()) {
+        std::size_t id = 0;
+        for (const Event &event : protocolEvents()) {
+            frames += "MESSAGE\nsubscription:1\nmessage-id:" + std::to_string(id++) +
+                      "\ndestination:" + event.get_channel_name() + "\n\n" + messageBody(event);
+            frames += '\0';
+        }
+    }
+    return frames;
+}
+
+BENCH(protocol_create_connect_frame) {
+    for (std::size_t i = 0; i < iterations; ++i)
+        doNotOptimize(benchProtocol().createConnectFrame("127.0.0.1", "alice", "secret").size());
+}
+
+BENCH(protocol_create_subscribe_frame) {
+    for (std::size_t i = 0; i < iterations; ++i)
+        doNotOptimize(benchProtocol().createSubscribeFrame("police", "17").size());
+}
+
+BENCH(protocol_create_send_frame) {
+    static const std::string body = messageBody(protocolEvents()[0]);
+    benchProtocol().setStamping(false);
+    for (std::size_t i = 0; i < iterations; ++i)
+        doNotOptimize(benchProtocol().createSendFrame("police", body).size());
+}
+
+// With the sent-at and sequence headers the client adds by default
+BENCH(protocol_create_send_frame_stamped) {
+    static const std::string body = messageBody(protocolEvents()[0]);
+    benchProtocol().setStamping(true);
+    for (std::size_t i = 0; i < iterations; ++i)
+        doNotOptimize(benchProtocol().createSendFrame("police", body).size());
+    benchProtocol().setStamping(false);
+}
+
+// One frame per call, as getLine() reads them
+BENCH(frame_get_frame_ascii) {
+    ConnectionHandler handler("127.0.0.1", 0);
+    std::string frame;
+    for (std::size_t i = 0; i < iterations; i += FRAMES_PER_FEED) {
+        handler.feed(messageFrames());
+        for (std::size_t j = 0; j < FRAMES_PER_FEED && i + j < iterations; ++j) {
+            frame.clear();
+            handler.getFrameAscii(frame, '\0');
+        }
+    }
+    doNotOptimize(frame.size());
+}
+
+// Every buffered frame per call, as the reader thread reads them; per frame
+BENCH(frame_get_frames) {
+    ConnectionHandler handler("127.0.0.1", 0);
+    std::vector<std::string> frames;
+    for (std::size_t i = 0; i < iterations; i += FRAMES_PER_FEED) {
+        handler.feed(messageFrames());
+        frames.clear();
+        handler.getFrames(frames);
+    }
+    doNotOptimize(frames.size());
+}
+
+// A report file of FRAMES_PER_FEED events, per event
+BENCH(event_parse_file) {
+    static const std::string path = "/tmp/stomp_bench_events.json";
+    if (iterations == 0) {
+        std::ofstream file(path.c_str(), std::ios::trunc);
+        file << "{\n  \"channel_name\": \"police\",\n  \"events\": [\n";
+        for (std::size_t i = 0; i < protocolEvents().size(); ++i) {
+            const Event &event = protocolEvents()[i];
+            file << (i ? ",\n" : "") << "    {\"event_name\": \"" << event.get_name() << "\", \"city\": \""
+                 << event.get_city() << "\", \"date_time\": " << event.get_date_time() << ", \"description\": \""
+                 << event.get_description() << "\", \"general_information\": {\"active\": "
+                 << event.get_general_information().at("active") << ", \"forces_arrival_at_scene\": "
+                 << event.get_general_information().at("forces_arrival_at_scene") << "}}";
+        }
+        file << "\n  ]\n}\n";
+    }
+    for (std::size_t i = 0; i < iterations; i += FRAMES_PER_FEED)
+        doNotOptimize(parseEventsFile(path).events.size());
+}
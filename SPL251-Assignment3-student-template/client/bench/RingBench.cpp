@@ -0,0 +1,139 @@
+#include "Bench.h"
+#include "../include/ParkingSpot.h"
+#include "../include/RingBuffer.h"
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+// Thread handoffs: a producer passes iterations items to a consumer thread. The mutex/cv queue is what
+// KeyedThreadPool used before the rings (the consumer swaps out the whole deque per wakeup).
+
+static const std::size_t HANDOFF_CAPACITY = 4096;
+
+class MutexQueue
+{
+public:
+    MutexQueue() : mutex_(), changed_(), items_() {}
+    void push(std::size_t item) {
+        bool wake;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            wake = items_.empty();
+            items_.push_back(item);
+        }
+        if (wake)
+            changed_.notify_one();
+    }
+    void popBatch(std::deque<std::size_t> &out) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        changed_.wait(lock, [this]() { return !items_.empty(); });
+        out.swap(items_);
+    }
+
+private:
+    std::mutex mutex_;
+    std::condition_variable changed_;
+    std::deque<std::size_t> items_;
+};
+
+// A ring with the waits KeyedThreadPool puts around it
+template <class Ring>
+class ParkedRing
+{
+public:
+    ParkedRing() : ring_(HANDOFF_CAPACITY), readable_(), writable_() {}
+    void push(std::size_t item) {
+        while (!ring_.tryPush(item))
+            writable_.wait([this]() { return !ring_.full(); });
+        readable_.notify();
+    }
+    void popBatch(std::vector<std::size_t> &out) {
+        readable_.wait([this]() { return ring_.readable(); });
+        ring_.popBatch(out, HANDOFF_CAPACITY);
+        writable_.notify();
+    }
+
+private:
+    Ring ring_;
+    ParkingSpot readable_;
+    ParkingSpot writable_;
+};
+
+static void handoffMutex(std::size_t iterations) {
+    MutexQueue queue;
+    std::thread consumer([&queue, iterations]() {
+        std::deque<std::size_t> batch;
+        for (std::size_t received = 0; received < iterations; received += batch.size()) {
+            batch.clear();
+            queue.popBatch(batch);
+            doNotOptimize(batch.back());
+        }
+    });
+    for (std::size_t i = 0; i < iterations; ++i)
+        queue.push(i);
+    consumer.join();
+}
+
+template <class Ring>
+static void handoffRing(std::size_t iterations) {
+    ParkedRing<Ring> queue;
+    std::thread consumer([&queue, iterations]() {
+        std::vector<std::size_t> batch;
+        for (std::size_t received = 0; received < iterations; received += batch.size()) {
+            batch.clear();
+            queue.popBatch(batch);
+            doNotOptimize(batch.back());
+        }
+    });
+    for (std::size_t i = 0; i < iterations; ++i)
+        queue.push(i);
+    consumer.join();
+}
+
+BENCH(handoff_throughput_mutex_cv) { handoffMutex(iterations); }
+BENCH(handoff_throughput_spsc_ring) { handoffRing<SpscRing<std::size_t>>(iterations); }
+BENCH(handoff_throughput_mpsc_ring) { handoffRing<MpscRing<std::size_t>>(iterations); }
+
+// Latency: one item bounces between two threads, so every handoff finds the other side waiting
+static void pingPongMutex(std::size_t iterations) {
+    MutexQueue ping, pong;
+    std::thread echo([&ping, &pong, iterations]() {
+        std::deque<std::size_t> batch;
+        for (std::size_t i = 0; i < iterations; ++i) {
+            batch.clear();
+            ping.popBatch(batch);
+            pong.push(batch.front());
+        }
+    });
+    std::deque<std::size_t> batch;
+    for (std::size_t i = 0; i < iterations; ++i) {
+        ping.push(i);
+        batch.clear();
+        pong.popBatch(batch);
+    }
+    echo.join();
+}
+
+template <class Ring>
+static void pingPongRing(std::size_t iterations) {
+    ParkedRing<Ring> ping, pong;
+    std::thread echo([&ping, &pong, iterations]() {
+        std::vector<std::size_t> batch;
+        for (std::size_t i = 0; i < iterations; ++i) {
+            batch.clear();
+            ping.popBatch(batch);
+            pong.push(batch.front());
+        }
+    });
+    std::vector<std::size_t> batch;
+    for (std::size_t i = 0; i < iterations; ++i) {
+        ping.push(i);
+        batch.clear();
+        pong.popBatch(batch);
+    }
+    echo.join();
+}
+
+BENCH(handoff_round_trip_mutex_cv) { pingPongMutex(iterations); }
+BENCH(handoff_round_trip_spsc_ring) { pingPongRing<SpscRing<std::size_t>>(iterations); }
@@ -0,0 +1,76 @@
+#include "Bench.h"
+#include "BenchData.h"
+#include "../include/EventStore.h"
+#include "../include/Rollups.h"
+#include <climits>
+
+static const std::size_t ROLLUP_EVENTS = 200000;
+
+struct RollupData {
+    std::vector<Event> events;
+    EventStore store;
+    RollupTable rollups;
+
+    RollupData() : events(syntheticEvents(ROLLUP_EVENTS)), store(), rollups() {
+        for (const Event &event : events) {
+            store.insert(event);
+            rollups.add(event);
+        }
+        store.flush();
+    }
+};
+
+static const RollupData &rollupData() {
+    static const RollupData data;
+    return data;
+}
+
+// Hourly counts of a whole channel over the full 30 days: the histogram scans the channel's columns,
+// the rollup reads one bucket per hour
+static SummaryQuery channelQuery() {
+    SummaryQuery query;
+    query.channel = "channel0";
+    return query;
+}
+
+BENCH(rollup_add_event) {
+    const RollupData &data = rollupData();
+    RollupTable rollups;
+    for (std::size_t i = 0; i < iterations; ++i)
+        rollups.add(data.events[i % data.events.size()]);
+    doNotOptimize(rollups.bucketCount());
+}
+
+BENCH(rollup_channel_hourly_histogram) {
+    const RollupData &data = rollupData();
+    EventStore::Snapshot snapshot = data.store.snapshot();
+    std::vector<EventStore::Snapshot::HistogramBucket> buckets;
+    for (std::size_t i = 0; i < iterations; ++i) {
+        snapshot.histogram(channelQuery(), RollupTable::HOUR_SECONDS, buckets);
+        doNotOptimize(buckets.size());
+    }
+}
+
+BENCH(rollup_channel_hourly_rollup) {
+    const RollupData &data = rollupData();
+    for (std::size_t i = 0; i < iterations; ++i)
+        doNotOptimize(data.rollups.query("channel0", "", RollupResolution::Hour, INT_MIN, INT_MAX).size());
+}
+
+BENCH(rollup_city_daily_rollup) {
+    const RollupData &data = rollupData();
+    for (std::size_t i = 0; i < iterations; ++i)
+        doNotOptimize(data.rollups.query("channel0", "City 7", RollupResolution::Day, INT_MIN, INT_MAX).size());
+}
+
+BENCH(rollup_save_load) {
+    const RollupData &data = rollupData();
+    for (std::size_t i = 0; i < iterations; ++i) {
+        RollupTable loaded;
+        data.rollups.save("/tmp/stomp-bench.rollups");
+        loaded.load("/tmp/stomp-bench.rollups");
+        doNotOptimize(loaded.bucketCount());
+    }
+    if (iterations != 0)
+        benchReport("buckets", double(data.rollups.bucketCount()), "");
+}
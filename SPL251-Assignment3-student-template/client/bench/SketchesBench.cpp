@@ -0,0 +1,35 @@
+#include "Bench.h"
+#include "BenchData.h"
+#include "../include/ChannelStats.h"
+#include "../include/Sketches.h"
+#include "../include/Hash.h"
+#include <cmath>
+
+static const std::vector<Event> &sketchEvents() {
+    static const std::vector<Event> events = syntheticEvents(100000);
+    return events;
+}
+
+// Cost of the reader thread's per-MESSAGE update
+BENCH(stats_channel_add) {
+    const std::vector<Event> &events = sketchEvents();
+    ChannelStats stats;
+    for (std::size_t i = 0; i < iterations; ++i)
+        stats.add(events[i % events.size()]);
+}
+
+BENCH(sketch_hyperloglog_add) {
+    HyperLogLog hll;
+    for (std::size_t i = 0; i < iterations; ++i)
+        hll.addHash(mix64(i));
+    if (iterations >= 1000000)
+        benchReport("relative_error", std::fabs(hll.estimate() - double(iterations)) / iterations, "");
+}
+
+BENCH(sketch_space_saving_add) {
+    const std::vector<Event> &events = sketchEvents();
+    SpaceSaving top(ChannelStats::TOP_CAPACITY);
+    for (std::size_t i = 0; i < iterations; ++i)
+        top.add(events[i % events.size()].get_city());
+    doNotOptimize(top.entries().size());
+}
@@ -0,0 +1,74 @@
+#include "Bench.h"
+#include "BenchData.h"
+#include "../include/SummaryCache.h"
+
+static const std::size_t CACHE_EVENTS = 100000;
+static const std::size_t NEW_EVENTS_PER_RUN = 4;
+
+static void fillStore(EventStore &store) {
+    for (const Event &event : syntheticEvents(CACHE_EVENTS))
+        store.insert(event);
+    store.flush();
+}
+
+// One (channel, user) series: about 12500 of the events
+static SummaryQuery seriesQuery() {
+    SummaryQuery query;
+    query.channel = "channel0";
+    query.user = "user0";
+    query.file = "/tmp/stomp-bench-cached-summary.txt";
+    return query;
+}
+
+// What the summary command did before the cache: select, sort and render every report on every run
+BENCH(summary_repeat_uncached) {
+    static EventStore store;
+    if (store.snapshot().size() == 0)
+        fillStore(store);
+    SummaryQuery query = seriesQuery();
+    for (std::size_t i = 0; i < iterations; ++i) {
+        EventStore::Snapshot snapshot = store.snapshot();
+        std::vector<EventId> ids = snapshot.select(query);
+        std::vector<const Event *> events;
+        events.reserve(ids.size());
+        for (EventId id : ids)
+            events.push_back(&snapshot.get(id));
+        doNotOptimize(writeSummary(query, events, snapshot.aggregate(query)));
+    }
+}
+
+BENCH(summary_repeat_cached_unchanged) {
+    static EventStore store;
+    if (store.snapshot().size() == 0)
+        fillStore(store);
+    SummaryCache cache;
+    SummaryQuery query = seriesQuery();
+    for (std::size_t i = 0; i < iterations; ++i)
+        doNotOptimize(cache.write(store.snapshot(), query));
+}
+
+// Between runs a few newer reports arrive on the series, as on a live channel
+BENCH(summary_repeat_cached_new_events) {
+    static EventStore store;
+    static int newest = defaultShape().baseEpoch + defaultShape().days * 86400;
+    if (store.snapshot().size() == 0)
+        fillStore(store);
+    SummaryCache cache;
+    SummaryQuery query = seriesQuery();
+    cache.write(store.snapshot(), query);
+    std::size_t appended = 0;
+    for (std::size_t i = 0; i < iterations; ++i) {
+        for (std::size_t n = 0; n < NEW_EVENTS_PER_RUN; ++n) {
+            std::map<std::string, std::string> info;
+            info["active"] = "true";
+            Event event("channel0", "City 1", "Event 1", ++newest, "suspect fled north on foot", info);
+            event.setEventOwnerUser("user0");
+            store.insert(event);
+        }
+        SummaryCache::Outcome outcome;
+        doNotOptimize(cache.write(store.snapshot(), query, &outcome));
+        appended += outcome == SummaryCache::Outcome::Appended;
+    }
+    if (iterations != 0)
+        benchReport("appended_runs", double(appended) / iterations * 100, "%");
+}
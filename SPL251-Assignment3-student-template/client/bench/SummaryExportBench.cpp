@@ -0,0 +1,99 @@
+#include "Bench.h"
+#include "BenchData.h"
+#include "../include/SummaryExport.h"
+#include "../include/SummaryWriter.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+// 64 (channel, user) series of about 1500 events each
+static const EventStore &exportStore() {
+    static EventStore store;
+    if (store.snapshot().size() == 0) {
+        SyntheticShape shape = defaultShape();
+        shape.channels = 8;
+        shape.users = 8;
+        for (const Event &event : syntheticEvents(100000, shape))
+            store.insert(event);
+    }
+    return store;
+}
+
+static void runExport(std::size_t threads, std::size_t iterations) {
+    EventStore::Snapshot snapshot = exportStore().snapshot();
+    SummaryQuery filters;
+    filters.file = "/tmp/stomp-bench-summaries";
+    ThreadPool pool(threads);
+    for (std::size_t i = 0; i < iterations; ++i)
+        doNotOptimize(writeAllSummaries(snapshot, filters, pool).written);
+    if (iterations != 0)
+        benchReport("series", double(snapshot.series().size()), "");
+}
+
+BENCH(summary_all_1_thread) {
+    runExport(1, iterations);
+}
+
+BENCH(summary_all_2_threads) {
+    runExport(2, iterations);
+}
+
+BENCH(summary_all_4_threads) {
+    runExport(4, iterations);
+}
+
+static const std::size_t SUMMARY_REPORTS = 1000000;
+
+static const std::vector<const Event *> &summaryReports() {
+    static const std::vector<Event> events = syntheticEvents(SUMMARY_REPORTS);
+    static std::vector<const Event *> reports;
+    if (reports.empty()) {
+        for (const Event &event : events)
+            reports.push_back(&event);
+    }
+    return reports;
+}
+
+static double secondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// One summary of SUMMARY_REPORTS reports, next to one fwrite of as many bytes: the gap is what rendering
+// costs over just handing the bytes to the OS
+BENCH(summary_write_1m_reports) {
+    const std::vector<const Event *> &reports = summaryReports();
+    SummaryQuery query;
+    query.channel = "channel0";
+    query.user = "user0";
+    query.file = "/tmp/stomp-bench-summary.txt";
+    SummaryCounts counts;
+    counts.total = reports.size();
+    double writeSeconds = 0, fwriteSeconds = 0, bytes = 0;
+    for (std::size_t i = 0; i < iterations; ++i) {
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        doNotOptimize(writeSummary(query, reports, counts));
+        writeSeconds += secondsSince(start);
+
+        std::FILE *file = std::fopen(query.file.c_str(), "rb");
+        std::string written;
+        if (file) {
+            std::fseek(file, 0, SEEK_END);
+            written.assign(std::ftell(file), 'x');
+            std::fclose(file);
+        }
+        bytes += written.size();
+
+        start = std::chrono::steady_clock::now();
+        file = std::fopen("/tmp/stomp-bench-fwrite.txt", "wb");
+        if (file) {
+            doNotOptimize(std::fwrite(written.data(), 1, written.size(), file));
+            std::fclose(file);
+        }
+        fwriteSeconds += secondsSince(start);
+    }
+    if (iterations != 0) {
+        benchReport("summary_bytes", bytes / iterations, "B");
+        benchReport("summary_MB_per_s", bytes / writeSeconds / 1e6, "MB/s");
+        benchReport("fwrite_MB_per_s", bytes / fwriteSeconds / 1e6, "MB/s");
+    }
+}
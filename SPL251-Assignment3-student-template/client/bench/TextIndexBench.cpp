@@ -0,0 +1,108 @@
+#include "Bench.h"
+#include "../include/EventStore.h"
+#include "../include/TextIndex.h"
+#include <cmath>
+#include <random>
+
+static const std::size_t TEXT_DOCS = 1000000;
+
+// One million 16-word descriptions over a Zipf-like 20k word vocabulary; one in a thousand
+// mentions a "black SUV" so phrase queries have a realistic handful of matches.
+template <class Add>
+static void generateCorpus(Add add) {
+    std::mt19937 rng(11);
+    std::vector<double> weights(20000);
+    for (std::size_t i = 0; i < weights.size(); ++i)
+        weights[i] = 1.0 / std::pow(double(i + 1), 0.9);
+    std::discrete_distribution<int> word(weights.begin(), weights.end());
+    std::uniform_int_distribution<int> rare(0, 999);
+    for (TextIndex::DocId doc = 0; doc < TEXT_DOCS; ++doc) {
+        std::string text;
+        for (int w = 0; w < 16; ++w)
+            text += "w" + std::to_string(word(rng)) + (w % 5 == 4 ? ". " : " ");
+        if (rare(rng) == 0)
+            text += "Witnesses saw a Black SUV leaving.";
+        else if (rare(rng) == 0)
+            text += "A black sedan and a white SUV.";
+        add(doc, text);
+    }
+}
+
+static const TextIndex &textIndex() {
+    static TextIndex index;
+    static bool built = false;
+    if (!built) {
+        generateCorpus([](TextIndex::DocId doc, const std::string &text) { index.add(doc, text); });
+        built = true;
+        benchReport("index_bytes_per_doc", double(index.memoryBytes()) / TEXT_DOCS, "B");
+    }
+    return index;
+}
+
+static void runSearch(const std::string &query, std::size_t iterations) {
+    const TextIndex &index = textIndex();
+    for (std::size_t i = 0; i < iterations; ++i)
+        doNotOptimize(index.search(query, 10));
+}
+
+BENCH(text_search_phrase) {
+    runSearch("\"black suv\"", iterations);
+}
+
+BENCH(text_search_rare_terms) {
+    runSearch("black suv", iterations);
+}
+
+BENCH(text_search_common_terms) {
+    runSearch("w1 w2", iterations);
+}
+
+BENCH(text_index_add) {
+    TextIndex index;
+    const std::string text = "Black SUV struck a pedestrian at Main Street and fled the scene. Victim sustained "
+                             "serious injuries and was transported to the hospital.";
+    for (std::size_t i = 0; i < iterations; ++i)
+        index.add(static_cast<TextIndex::DocId>(i), text);
+    doNotOptimize(index.termCount());
+}
+
+// The same corpus as reports in an EventStore, spread over every shard. Most of it sits in merged
+// segments; each shard's active block is part-filled (a channel gets 15625 reports, 265 past a block
+// boundary) and is searched through the index the writer keeps for it.
+static const std::size_t STORE_CHANNELS = 64;
+
+static const EventStore &textStore() {
+    static EventStore store;
+    if (store.snapshot().size() == 0) {
+        generateCorpus([](TextIndex::DocId doc, const std::string &text) {
+            Event event("channel" + std::to_string(doc % STORE_CHANNELS), "City", "Report",
+                        1734961200 + static_cast<int>(doc), text, std::map<std::string, std::string>());
+            event.setEventOwnerUser("user");
+            store.insert(event);
+        });
+        store.flush();
+    }
+    return store;
+}
+
+static void runStoreSearch(const std::string &query, std::size_t iterations) {
+    EventStore::Snapshot snapshot = textStore().snapshot();
+    for (std::size_t i = 0; i < iterations; ++i)
+        doNotOptimize(snapshot.search(query, 10));
+}
+
+BENCH(text_store_search_phrase) {
+    runStoreSearch("\"black suv\"", iterations);
+}
+
+BENCH(text_store_search_rare_terms) {
+    runStoreSearch("black suv", iterations);
+}
+
+BENCH(text_store_search_common_terms) {
+    runStoreSearch("w1 w2", iterations);
+}
+
+BENCH(text_store_search_no_match) {
+    runStoreSearch("black zebra", iterations);
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstdint>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include "../include/event.h"
+#include "../include/Sketches.h"
+
+// Live statistics for one channel, kept in fixed memory without retaining events.
+// Windows are in event time: "last hour" ends at the newest date_time reported on the channel.
+class ChannelStats
+{
+public:
+    static const int WINDOW_SECONDS = 3600;
+    static const std::size_t TOP_CAPACITY = 64; // Space-Saving counters per summary
+
+    ChannelStats();
+
+    void add(const Event &event);
+    void render(std::ostream &out, std::size_t topCount) const;
+
+private:
+    std::uint64_t total_;
+    std::uint64_t active_;
+    long long newest_;                         // newest date_time seen
+    TimeBuckets<std::uint64_t> reports_;       // 60 one-minute buckets
+    TimeBuckets<std::uint64_t> activeReports_;
+    TimeBuckets<SpaceSaving> windowCities_;    // 12 five-minute Space-Saving summaries
+    SpaceSaving cities_;
+    SpaceSaving eventNames_;
+    HyperLogLog users_;
+    HyperLogLog distinctCities_;
+};
+
+// Per-channel statistics for every MESSAGE received. Thread-safe.
+class StreamStats
+{
+public:
+    StreamStats();
+
+    void add(const Event &event);
+    // add() of every event, under one lock
+    void add(const std::vector<Event> &events);
+    // Writes the statistics of channel to out. Returns false if nothing was received on it.
+    bool render(const std::string &channel, std::ostream &out, std::size_t topCount = 10) const;
+    void clear();
+
+private:
+    mutable std::mutex mutex_;
+    std::unordered_map<std::string, ChannelStats> channels_;
+};
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include "../include/EventStore.h"
+
+// A sealed block of events packed for the cold tier. Channel, user, city, event name and every general
+// information key and value go through one per-block string dictionary; descriptions are concatenated
+// and deflated as a single buffer, so wording repeated across reports compresses well.
+// Immutable once built; inflate() rebuilds the events and may be called from several threads.
+class ColdBlock
+{
+public:
+    ColdBlock();
+    ColdBlock(const ColdBlock &) = delete;
+    ColdBlock &operator=(const ColdBlock &) = delete;
+
+    static std::shared_ptr<const ColdBlock> compress(const EventBlock &events);
+    // A new block holding the same events in the same slots
+    std::unique_ptr<EventBlock> inflate() const;
+
+    std::size_t count() const { return times_.size(); }
+    // Heap bytes held by the packed block
+    std::size_t memoryBytes() const;
+
+private:
+    static const std::size_t FIELDS = 4; // channel, user, city, event name
+
+    std::vector<std::string> strings_;           // dictionary, ids index it
+    std::vector<int> times_;                     // date_time per slot
+    std::vector<std::uint32_t> fields_;          // FIELDS string ids per slot
+    std::vector<std::uint32_t> infoEnds_;        // per slot, end of its pairs in info_
+    std::vector<std::uint32_t> info_;            // general information as (key id, value id) pairs
+    std::vector<std::uint32_t> descriptionEnds_; // per slot, end of its description once inflated
+    std::string descriptions_;                   // deflated concatenation of the descriptions
+};
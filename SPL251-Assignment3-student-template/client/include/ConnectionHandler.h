@@ -1,20 +1,45 @@
 #pragma once
 
+#include <atomic>
 #include <string>
 #include <iostream>
+#include <vector>
 #include <boost/asio.hpp>
+#include "../include/Logger.h"
+#include "../include/Metrics.h"
 
 using boost::asio::ip::tcp;
 
 class ConnectionHandler {
 private:
+	static const std::size_t FRAME_COMMANDS = 5; // CONNECTED, MESSAGE, RECEIPT, ERROR and anything else
+	static const std::size_t READ_CHUNK = 64 * 1024;
+
 	const std::string host_;
 	const short port_;
 	boost::asio::io_service io_service_;   // Provides core I/O functionality
 	tcp::socket socket_;
+	Logger &logger_;                       // connection messages, category Connection
+	std::atomic<bool> shutDown_;           // reads failing after shutdown() are expected, not reported
+	std::string received_;                 // bytes read from the socket and not consumed yet, from receivedStart_
+	std::size_t receivedStart_;
+	std::vector<char> readBuffer_;         // READ_CHUNK bytes the socket is read into, allocated once
+	MetricsRegistry::Counter socketReads_;
+	MetricsRegistry::Counter bytesReceived_;
+	MetricsRegistry::Counter bytesSent_;
+	MetricsRegistry::Counter framesReceived_[FRAME_COMMANDS];     // per command
+	MetricsRegistry::Counter frameBytesReceived_[FRAME_COMMANDS];
+
+	// Appends whatever the socket has (blocking for at least one byte) to received_
+	bool receiveMore();
+	void compact();
+	// Counts the frame received_[start, end) under its command
+	void countFrame(std::size_t start, std::size_t end);
 
 public:
-	ConnectionHandler(std::string host, short port);
+	// Socket and received frame counts go to metrics
+	ConnectionHandler(std::string host, short port, Logger &logger = Logger::console(),
+	                  MetricsRegistry &metrics = MetricsRegistry::global());
 
 	virtual ~ConnectionHandler();
 
@@ -25,6 +50,11 @@ public:
 	// Returns false in case the connection is closed before bytesToRead bytes can be read.
 	bool getBytes(char bytes[], unsigned int bytesToRead);
 
+	// Read every complete frame available - blocking until there is at least one - and append them to
+	// frames, without their '\0'. Reads the socket in large chunks, so a burst of frames costs one wakeup.
+	// Returns false in case the connection is closed first.
+	bool getFrames(std::vector<std::string> &frames);
+
 	// Send a fixed number of bytes from the client - blocking.
 	// Returns false in case the connection is closed before all the data is sent.
 	bool sendBytes(const char bytes[], int bytesToWrite);
@@ -48,4 +78,12 @@ public:
 	// Close down the connection properly.
 	void close();
 
+	// Append bytes to the receive buffer as if the server had sent them: getFrames(), getFrameAscii() and
+	// getBytes() return them before reading the socket. For replaying captured traffic and benchmarks.
+	void feed(const std::string &bytes);
+
+	// Stop both directions but keep the socket open, so a getLine() blocked on another thread
+	// returns false. Close it once that thread is done.
+	void shutdown();
+
 }; //class ConnectionHandler
@@ -0,0 +1,18 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+// Formats epoch seconds as local "DD/MM/YY HH:MM" without going through std::localtime on every call.
+// The local UTC offset is looked up with localtime_r once per UTC hour and cached per thread, the rest is
+// integer arithmetic written straight into the caller's buffer. Hours that contain a DST switch are not
+// cached and fall back to localtime_r. Safe to call from any thread; TZ is assumed not to change at runtime.
+class DateFormatter
+{
+public:
+    static const std::size_t DATE_LENGTH = 14; // strlen("DD/MM/YY HH:MM")
+
+    // Writes exactly DATE_LENGTH characters (no terminating null) to out and returns DATE_LENGTH.
+    static std::size_t format(int epoch, char *out);
+    static std::string format(int epoch);
+};
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstdint>
+#include <mutex>
+#include <unordered_set>
+#include <vector>
+#include "../include/Sketches.h"
+
+// Recognizes events received more than once (after a reconnect, or a report file sent twice) by their
+// content hash, in bounded memory. The most recent hashes are kept exactly; older ones only in Bloom
+// filters, so a new event may rarely be taken for an old one. History is kept in two Bloom generations
+// of `generationCapacity` events each: when the newer one fills up, the older one is forgotten.
+// Thread-safe.
+class Deduplicator
+{
+public:
+    static const std::size_t DEFAULT_RECENT = 1 << 16;
+    static const std::size_t DEFAULT_GENERATION = 1 << 18;
+    static const int BLOOM_BITS_PER_EVENT = 10; // at least; under 1% false positives per full generation
+    static const int BLOOM_HASHES = 7;
+
+    explicit Deduplicator(std::size_t recentCapacity = DEFAULT_RECENT,
+                          std::size_t generationCapacity = DEFAULT_GENERATION);
+
+    // True the first time hash is seen, false when it is (probably) a duplicate
+    bool firstSeen(std::uint64_t hash);
+    // firstSeen() of every hash in order, under one lock: fresh[i] is its answer for hashes[i]
+    void firstSeen(const std::vector<std::uint64_t> &hashes, std::vector<bool> &fresh);
+    // Whether firstSeen(hash) would report a duplicate, without remembering hash
+    bool seen(std::uint64_t hash) const;
+    void clear();
+
+    std::uint64_t duplicates() const;
+    std::size_t memoryBytes() const;
+
+private:
+    mutable std::mutex mutex_;
+    std::size_t recentCapacity_;
+    std::size_t generationCapacity_;
+    std::unordered_set<std::uint64_t> recent_;
+    std::vector<std::uint64_t> recentOrder_; // ring of the hashes in recent_, oldest at recentNext_
+    std::size_t recentNext_;
+    BloomFilter current_;  // every hash of this generation, including the ones still in recent_
+    BloomFilter previous_;
+    std::size_t currentCount_;
+    std::uint64_t duplicates_;
+
+    bool seenLocked(std::uint64_t hash) const;
+    bool firstSeenLocked(std::uint64_t hash);
+};
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include "../include/Metrics.h"
+
+// Publish-to-delivery latency of the MESSAGEs received, and the messages missing from them, per channel.
+// A sender's StompProtocol stamps each SEND with two headers the broker forwards on the MESSAGE:
+//   sent-at:  its wall clock when it built the frame, in nanoseconds since the epoch
+//   sequence: <stream>/<n>, the stream unique to the sender's session and n counting its frames per
+//             channel from 1
+// Latency between hosts is only as accurate as their clock synchronization. A jump in n counts the
+// skipped messages as missing; one arriving after a later one counts as late. A stream first seen
+// mid-way (we subscribed after it started) starts clean. Thread-safe.
+class DeliveryLatency
+{
+public:
+    // The totals over every channel also go to metrics
+    explicit DeliveryLatency(MetricsRegistry &metrics);
+
+    // A MESSAGE on channel, with its sent-at and sequence header values ("" when absent), read at
+    // receivedAt (nanoseconds since the epoch)
+    void add(const std::string &channel, const std::string &sentAt, const std::string &sequence,
+             std::int64_t receivedAt);
+    // One line per channel, or only channel's when it is not empty. False when there is nothing to show.
+    bool render(const std::string &channel, std::ostream &out) const;
+    void clear();
+
+    // The totals over every channel, in metrics; shared by every DeliveryLatency of one registry
+    MetricsRegistry::Histogram latencyMetric() const { return latency_; }
+    MetricsRegistry::Counter missingMetric() const { return missing_; }
+    MetricsRegistry::Counter lateMetric() const { return late_; }
+
+    // Now, in the unit of sent-at
+    static std::int64_t now();
+
+private:
+    struct ChannelLatency {
+        MetricsRegistry::HistogramSnapshot latency;
+        std::uint64_t received;
+        std::uint64_t missing;
+        std::uint64_t late;
+        std::unordered_map<std::string, std::uint64_t> nextSequence; // per stream
+
+        ChannelLatency() : latency(), received(0), missing(0), late(0), nextSequence() {}
+    };
+
+    mutable std::mutex mutex_;
+    std::map<std::string, ChannelLatency> channels_; // sorted for render()
+    MetricsRegistry::Histogram latency_;
+    MetricsRegistry::Counter missing_;
+    MetricsRegistry::Counter late_;
+
+    static void renderChannel(const std::string &name, const ChannelLatency &channel, std::ostream &out);
+};
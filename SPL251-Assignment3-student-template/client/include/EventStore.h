@@ -0,0 +1,349 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+#include "../include/event.h"
+#include "../include/ParkingSpot.h"
+#include "../include/SummaryQuery.h"
+#include "../include/TextIndex.h"
+
+// Identifies an event within a snapshot: shard (3 bits) | sequence number within the shard (29 bits).
+// Sequence numbers grow in arrival order.
+typedef std::uint32_t EventId;
+typedef std::uint32_t EventSeq;
+
+typedef std::unordered_map<std::string, std::vector<EventSeq>> PostingIndex; // value -> events in report order
+
+// Which optional secondary indexes the store maintains. Each maps an attribute value to a posting list
+// holding every event with that value (across channels and users), kept in report order.
+struct EventStoreOptions {
+    bool indexCity;
+    bool indexEventName;
+    std::vector<std::string> indexedInfoKeys; // general_information keys to index, e.g. "active"
+    bool indexDescriptions;                   // full-text index for search()
+    // Sealed blocks whose newest date_time is older than this many seconds are packed into the cold
+    // tier (see ColdBlock) and only inflated when a snapshot reads their events. 0 keeps every block hot.
+    int coldAfterSeconds;
+
+    EventStoreOptions(); // city, event name, "active" and descriptions; no cold tier
+};
+
+// Assigns small ids to the distinct values of one segment column. A segment holds at most
+// MAX_MERGED_BLOCKS * CAPACITY = 65536 events, so 16-bit ids always suffice.
+struct StringDictionary {
+    std::unordered_map<std::string, std::uint16_t> ids;
+    std::vector<std::string> values; // by id
+
+    StringDictionary() : ids(), values() {}
+
+    std::uint16_t intern(const std::string &value);
+    bool find(const std::string &value, std::uint16_t &id) const;
+};
+
+// Column-oriented copy of the fields aggregates look at, one entry per event of a segment by seq - first.
+// Strings become dictionary ids and the two summary flags share a byte, so counting and bucketing scan
+// a few packed arrays (about 13 bytes per event) instead of each event's strings and maps.
+struct EventColumns {
+    static const std::uint8_t ACTIVE = 1;
+    static const std::uint8_t FORCES_ARRIVAL_AT_SCENE = 2;
+
+    std::vector<int> times; // date_time
+    std::vector<std::uint16_t> channels;
+    std::vector<std::uint16_t> series; // (channel, user)
+    std::vector<std::uint16_t> cities;
+    std::vector<std::uint16_t> names;
+    std::vector<std::uint8_t> flags;
+    StringDictionary channelIds;
+    StringDictionary seriesIds; // keyed by channel + '\0' + user
+    StringDictionary cityIds;
+    StringDictionary nameIds;
+
+    EventColumns();
+
+    void reserve(std::size_t count);
+    void append(const Event &event);
+    // Append every row of other, translating its ids into this dictionary
+    void append(const EventColumns &other);
+    std::size_t memoryBytes() const;
+
+    static std::uint8_t flagsOf(const Event &event);
+    static std::string seriesKey(const std::string &channel, const std::string &user);
+};
+
+// Fixed-capacity append-only array of events. One writer appends and publishes the new count with a
+// release store; readers load the count with acquire and may read every event below it without locking.
+// Each slot also keeps the event's date_time, summary flags and a hash of its (channel, user) so
+// unindexed scans reject most events without touching them.
+class EventBlock
+{
+public:
+    static const std::size_t CAPACITY = 1024;
+    static const std::size_t CATCH_UP_SLOTS = 4; // most slots indexDescriptions() indexes per call
+
+    // Full-text index of the block's descriptions, doc ids are slots. The writer extends it as it appends
+    // but never waits for it: while a reader holds the mutex, new slots stay out until a later append (or
+    // the indexer thread, once the block is sealed). Slots from `indexed` on must be indexed by the reader.
+    struct Descriptions {
+        std::mutex mutex;
+        std::shared_ptr<TextIndex> index; // null until the first slot, and again after release
+        std::size_t indexed;              // slots [0, indexed) are in index
+
+        Descriptions() : mutex(), index(), indexed(0) {}
+    };
+
+    EventBlock();
+    ~EventBlock();
+    EventBlock(const EventBlock &) = delete;
+    EventBlock &operator=(const EventBlock &) = delete;
+
+    // Writer only. Returns the slot, or CAPACITY when the block is full.
+    std::size_t append(const Event &event);
+    std::size_t count() const { return count_.load(std::memory_order_acquire); }
+    const Event &at(std::size_t slot) const { return *reinterpret_cast<const Event *>(&storage_[slot]); }
+    std::uint64_t seriesHash(std::size_t slot) const { return keys_[slot].series; }
+    int dateTime(std::size_t slot) const { return keys_[slot].dateTime; }
+    std::uint8_t flags(std::size_t slot) const { return keys_[slot].flags; } // EventColumns::ACTIVE...
+
+    // Internally synchronized, hence reachable through a const block
+    Descriptions &descriptions() const { return *descriptions_; }
+    // Writer only: index the descriptions appended so far, unless a reader holds the index
+    void indexDescriptions();
+    // Index every remaining slot of the sealed block; the returned index no longer changes
+    std::shared_ptr<const TextIndex> completeDescriptions() const;
+    // Drop the block's hold on its index once a segment owns it; readers then index the block themselves
+    void releaseDescriptions() const;
+
+    static std::uint64_t seriesHash(const std::string &channel, const std::string &user);
+
+private:
+    typedef std::aligned_storage<sizeof(Event), alignof(Event)>::type Storage;
+    struct SlotKey {
+        std::uint64_t series;
+        int dateTime;
+        std::uint8_t flags;
+    };
+
+    std::unique_ptr<Storage[]> storage_;
+    std::unique_ptr<SlotKey[]> keys_;
+    std::atomic<std::size_t> count_;
+    std::unique_ptr<Descriptions> descriptions_;
+};
+
+struct ShardView;
+class ColdBlock;
+
+// Indexes over a run of consecutive sealed blocks of one shard, never modified once published.
+// The indexer thread gives each sealed block its own segment; two neighbouring segments covering the same
+// number of blocks are merged (up to MAX_MERGED_BLOCKS), so a query visits few segments.
+struct IndexSegment {
+    static const std::size_t MAX_MERGED_BLOCKS = 64;
+
+    EventSeq first; // covers sequence numbers [first, last)
+    EventSeq last;
+    int minTime;
+    int maxTime;
+    EventColumns columns; // time slicing and aggregates read these instead of the events
+    std::unordered_map<std::string, std::unordered_map<std::string, std::vector<EventSeq>>> series;
+    PostingIndex cityIndex;
+    PostingIndex nameIndex;
+    std::unordered_map<std::string, PostingIndex> infoIndexes; // general_information key -> index
+    std::shared_ptr<const TextIndex> descriptions; // doc ids are seq - first; null without indexDescriptions
+
+    IndexSegment();
+    IndexSegment(const IndexSegment &) = delete;
+    IndexSegment &operator=(const IndexSegment &) = delete;
+
+    // Segment for the sealed block number `block` of view
+    static std::shared_ptr<const IndexSegment> build(const ShardView &view, std::size_t block,
+                                                     const EventStoreOptions &options);
+    // Segment covering older followed by newer, which must be adjacent
+    static std::shared_ptr<const IndexSegment> merge(const IndexSegment &older, const IndexSegment &newer);
+    int timeOf(EventSeq seq) const { return columns.times[seq - first]; }
+    const std::string &nameOf(EventSeq seq) const { return columns.nameIds.values[columns.names[seq - first]]; }
+    std::size_t indexMemoryBytes() const;
+};
+
+// A sealed block, hot or packed
+struct SealedBlock {
+    std::shared_ptr<const EventBlock> events; // null once the block moved to the cold tier
+    std::shared_ptr<const ColdBlock> cold;    // null while it is hot
+    int newest;                               // newest date_time of the block
+
+    SealedBlock() : events(), cold(), newest(0) {}
+};
+
+// What readers of one shard see. Replaced as a whole (never modified) whenever a block is sealed or the
+// indexer publishes new segments; only the active block's event count moves between replacements.
+// Sealed blocks sit in chunks shared by successive views, so publishing a view copies a pointer per
+// chunk and the one chunk that changed, not every block.
+struct ShardView {
+    static const std::size_t CHUNK_BLOCKS = 64;
+
+    std::size_t blockCount; // sealed blocks; block i holds sequence numbers from i * CAPACITY
+    std::vector<std::shared_ptr<std::vector<SealedBlock>>> chunks; // CHUNK_BLOCKS blocks each, the last may be
+                                                                   // partial; never modified once published
+    std::size_t coldCount;                                   // blocks in the cold tier, all of them indexed
+    std::vector<std::shared_ptr<const IndexSegment>> segments; // oldest first, covering the indexed blocks
+    std::shared_ptr<EventBlock> active; // may be null
+
+    ShardView() : blockCount(0), chunks(), coldCount(0), segments(), active() {}
+
+    const SealedBlock &sealed(std::size_t block) const
+    {
+        return (*chunks[block / CHUNK_BLOCKS])[block % CHUNK_BLOCKS];
+    }
+    // For a view not published yet: copy-on-write updates of the chunks
+    void appendSealed(const SealedBlock &block);
+    SealedBlock &modifySealed(std::size_t block);
+
+    // Hot events only; readers go through EventStore::Snapshot, which inflates cold blocks
+    const Event &at(EventSeq seq) const;
+    // Sealed blocks below this are covered by segments; the rest wait for the indexer
+    std::size_t indexedBlocks() const
+    {
+        return segments.empty() ? 0 : segments.back()->last / EventBlock::CAPACITY;
+    }
+};
+
+// Holds every event received from the subscribed channels, sharded by channel.
+// Writers append to the shard's active block and are never blocked by readers. Every 1024 events the
+// block is sealed and a new shard view is published (RCU-style) with an atomic shared_ptr store; an
+// indexer thread then builds and merges its segment, packs aged blocks, and publishes the same way.
+// snapshot() captures each shard's view and active count: a consistent, immutable state that can be
+// queried for as long as needed while ingestion continues. Thread-safe.
+class EventStore
+{
+public:
+    static const std::size_t SHARD_COUNT = 8;
+
+    class Snapshot
+    {
+    public:
+        Snapshot();
+
+        const Event &get(EventId id) const;
+        std::size_t size() const;
+        bool hasChannel(const std::string &channel) const;
+        // Every (channel, user) pair with at least one event, sorted
+        std::vector<std::pair<std::string, std::string>> series() const;
+
+        // Ids of the events in query's (channel, user) series that pass all of its filters, in report order
+        std::vector<EventId> select(const SummaryQuery &query) const;
+        // Number of events of the (channel, user) series in this snapshot. Only grows between clears, so
+        // two snapshots of the store hold the same series events exactly when their versions are equal.
+        std::size_t seriesVersion(const std::string &channel, const std::string &user) const;
+        // Marks everything this snapshot holds on channel's shard, for selectSince() on a later snapshot
+        EventId watermark(const std::string &channel) const;
+        // select(query) restricted to the events inserted after watermark was taken (with no clear between)
+        std::vector<EventId> selectSince(const SummaryQuery &query, EventId watermark) const;
+
+        struct SearchHit {
+            EventId id;
+            double score; // BM25 over the whole snapshot
+        };
+        // Events whose description contains every word and "quoted phrase" of text, best match first
+        std::vector<SearchHit> search(const std::string &text, std::size_t limit) const;
+
+        // Counts of the events select(query) returns; an empty query.user counts the whole channel.
+        // Runs over the segment columns, touching events only for general information filters
+        // other than active=true and forces_arrival_at_scene=true.
+        SummaryCounts aggregate(const SummaryQuery &query) const;
+
+        struct HistogramBucket {
+            int start; // the bucket covers [start, start + bucketSeconds), aligned to the epoch
+            SummaryCounts counts;
+
+            HistogramBucket() : start(0), counts() {}
+        };
+        static const std::size_t MAX_HISTOGRAM_BUCKETS = 1 << 16;
+        // Counts per time bucket from the first to the last matching event, empty buckets included.
+        // Returns false, leaving buckets empty, when that span needs more than MAX_HISTOGRAM_BUCKETS
+        // (or exceeds 2^32 seconds).
+        bool histogram(const SummaryQuery &query, int bucketSeconds, std::vector<HistogramBucket> &buckets) const;
+
+        // Report order: date_time, then event name, then arrival
+        bool reportOrderLess(EventId a, EventId b) const;
+
+    private:
+        friend class EventStore;
+        struct Shard {
+            std::shared_ptr<const ShardView> view;
+            std::size_t activeCount;
+        };
+        struct ColdCache; // the cold blocks this snapshot has inflated so far
+
+        struct TimedId {
+            int time; // date_time, kept next to the id so merging rarely needs the event
+            EventId id;
+        };
+
+        std::shared_ptr<const EventStoreOptions> options_;
+        std::vector<Shard> shards_;
+        std::shared_ptr<ColdCache> cold_; // null when no shard has cold blocks
+
+        const Event &event(std::size_t shard, EventSeq seq) const;
+        const EventBlock &inflated(std::size_t shard, std::size_t block) const;
+
+        std::vector<EventId> selectFrom(const SummaryQuery &query, EventSeq since) const;
+        void selectSegment(std::size_t shard, const IndexSegment &segment, const SummaryQuery &query, EventSeq since,
+                           std::vector<TimedId> &selected) const;
+        // Calls visit(match, times, flags) for batches of EventBlock::CAPACITY rows of query's channel
+        // shard; match[i] is 1 for the rows that pass query
+        template <class Visitor>
+        void scanColumns(const SummaryQuery &query, Visitor visit) const;
+        // Calls visit(block, first, count) for the blocks of shard no segment covers: sealed blocks waiting
+        // for the indexer, then the active block; first is the sequence number of slot 0
+        template <class Visitor>
+        void forEachUnindexed(const Shard &shard, Visitor visit) const;
+    };
+
+    explicit EventStore(const EventStoreOptions &options = EventStoreOptions());
+    EventStore(const EventStore &) = delete;
+    EventStore &operator=(const EventStore &) = delete;
+    ~EventStore();
+
+    // Safe to call from several threads; writers of different channels rarely share a shard lock
+    void insert(const Event &event);
+    // insert() of every event in order, taking a shard's lock once per run of events on that shard
+    void insert(const std::vector<Event> &events);
+    Snapshot snapshot() const;
+    // Drops every event. Snapshots taken earlier keep theirs.
+    void clear();
+    // Waits until the indexer has indexed (and packed, with a cold tier) every block sealed before the call
+    void flush();
+
+    const EventStoreOptions &options() const { return *options_; }
+    // Approximate heap bytes held by the secondary indexes (not counting the full-text index)
+    std::size_t indexMemoryBytes() const;
+    // Approximate heap bytes held by the events themselves, hot and cold tiers separately
+    void eventMemoryBytes(std::size_t &hot, std::size_t &cold) const;
+
+private:
+    struct Shard {
+        std::mutex writer; // serializes the writers of this shard and the indexer's publishing
+        std::shared_ptr<const ShardView> view; // accessed with std::atomic_load / std::atomic_store
+        std::uint64_t generation; // bumped by clear(), so the indexer drops work on the old events
+
+        Shard() : writer(), view(std::make_shared<ShardView>()), generation(0) {}
+    };
+
+    std::shared_ptr<const EventStoreOptions> options_;
+    std::unique_ptr<Shard[]> shards_;
+    std::atomic<std::uint64_t> sealed_;  // blocks sealed
+    std::atomic<std::uint64_t> indexed_; // of those, blocks the indexer has finished
+    std::atomic<bool> stopping_;
+    ParkingSpot pending_;  // the indexer waits for sealed blocks
+    ParkingSpot caughtUp_; // flush() waits for indexed_
+    std::thread indexer_;
+
+    void insertLocked(Shard &shard, const Event &event);
+    void indexBlocks();
+    void indexShard(Shard &shard);
+};
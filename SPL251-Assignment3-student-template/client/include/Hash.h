@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// 64-bit FNV-1a over a byte range, good enough to spread short keys but weak in the low bits
+inline std::uint64_t fnv1a64(const char *data, std::size_t length, std::uint64_t seed = 14695981039346656037ULL)
+{
+    std::uint64_t hash = seed;
+    for (std::size_t i = 0; i < length; ++i) {
+        hash ^= static_cast<unsigned char>(data[i]);
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+// splitmix64 finalizer: every input bit affects every output bit
+inline std::uint64_t mix64(std::uint64_t value)
+{
+    value ^= value >> 30;
+    value *= 0xbf58476d1ce4e5b9ULL;
+    value ^= value >> 27;
+    value *= 0x94d049bb133111ebULL;
+    value ^= value >> 31;
+    return value;
+}
+
+inline std::uint64_t hash64(const std::string &text)
+{
+    return mix64(fnv1a64(text.data(), text.size()));
+}
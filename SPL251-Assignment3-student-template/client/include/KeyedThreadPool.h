@@ -0,0 +1,57 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <vector>
+#include "../include/ParkingSpot.h"
+#include "../include/RingBuffer.h"
+
+// Worker threads with one queue each. A task goes to the worker picked by its key, so tasks with the
+// same key run one at a time in submission order while different keys run in parallel.
+// The queues are bounded lock-free rings: a worker takes everything queued at once, and parks only after
+// spinning on an empty ring; a submitter finding the ring full waits the same way for room. Tasks must
+// not submit to their own pool, they could wait on themselves.
+// The destructor finishes every queued task before joining the workers.
+class KeyedThreadPool
+{
+public:
+    static const std::size_t QUEUE_CAPACITY = 4096; // tasks per worker
+    static const std::size_t BATCH = 256;           // tasks a worker takes per pop
+
+    // threads == 0 uses one worker per hardware thread
+    explicit KeyedThreadPool(std::size_t threads = 0);
+    ~KeyedThreadPool();
+    KeyedThreadPool(const KeyedThreadPool &) = delete;
+    KeyedThreadPool &operator=(const KeyedThreadPool &) = delete;
+
+    void submit(std::size_t key, std::function<void()> task);
+    // Runs task once every task submitted before it has finished, on one of the workers
+    void submitAfterAll(std::function<void()> task);
+    // Blocks until every task submitted so far has finished
+    void wait();
+    // Tasks submitted and not finished yet, over all workers
+    std::size_t pending() const;
+    std::size_t size() const { return workers_.size(); }
+
+private:
+    struct Worker {
+        MpscRing<std::function<void()>> queue;
+        ParkingSpot readable;  // the worker waits for tasks
+        ParkingSpot writable;  // submitters wait for room
+        ParkingSpot idle;      // wait() waits for completed to catch up
+        std::atomic<std::size_t> submitted;
+        std::atomic<std::size_t> completed;
+        std::atomic<bool> stopping;
+        std::thread thread;
+
+        Worker() : queue(QUEUE_CAPACITY), readable(), writable(), idle(), submitted(0), completed(0),
+                   stopping(false), thread() {}
+    };
+
+    std::vector<std::unique_ptr<Worker>> workers_;
+
+    void work(Worker &worker);
+};
@@ -0,0 +1,131 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../include/ParkingSpot.h"
+#include "../include/RingBuffer.h"
+
+enum class LogLevel { Debug, Info, Warn, Error, Off };
+
+enum class LogCategory {
+    Client,     // command output and errors
+    Frame,      // frames received from the server
+    Connection, // the socket
+    Protocol,   // StompProtocol
+    Count
+};
+
+enum class LogFormat {
+    Plain,     // the message alone, as the console always showed it
+    Structured // one logfmt line: ts, level, category, thread and msg
+};
+
+// Asynchronous logger. Each logging thread appends records to a ring of its own; a background thread
+// drains every ring, orders the records by when they were logged and writes them to the sinks in
+// batches, flushing once per batch. A record below its category's level costs one relaxed load when
+// logged through STOMP_LOG or after checking enabled(). Thread-safe; configure the sinks before logging.
+class Logger
+{
+public:
+    static const std::size_t RING_CAPACITY = 1024; // records per thread before the thread waits for the writer
+
+    Logger();
+    // Writes everything logged so far, then stops the writer. No thread may be logging meanwhile.
+    ~Logger();
+    Logger(const Logger &) = delete;
+    Logger &operator=(const Logger &) = delete;
+
+    // Plain records up to Info on std::cout, Warn and above on std::cerr; for code without a logger of its own
+    static Logger &console();
+
+    // Records with minLevel <= level <= maxLevel go to stream, which must outlive the logger
+    void addSink(std::ostream *stream, LogFormat format, LogLevel minLevel, LogLevel maxLevel = LogLevel::Error);
+    // The same, for a file the logger opens for appending. False if it can't be opened.
+    bool addFileSink(const std::string &path, LogFormat format, LogLevel minLevel);
+
+    void setLevel(LogCategory category, LogLevel level);
+    void setLevel(LogLevel level); // every category
+    bool enabled(LogLevel level, LogCategory category) const {
+        return static_cast<int>(level) >= levels_[static_cast<int>(category)].load(std::memory_order_relaxed);
+    }
+
+    // Queues message (no trailing newline) if enabled
+    void log(LogLevel level, LogCategory category, std::string message);
+    // Blocks until every record logged before the call has been written and flushed
+    void flush();
+
+    static bool parseLevel(const std::string &name, LogLevel &level);
+    static bool parseCategory(const std::string &name, LogCategory &category);
+
+private:
+    struct Record {
+        std::uint64_t sequence;
+        LogLevel level;
+        LogCategory category;
+        std::chrono::system_clock::time_point time;
+        std::string message;
+        int thread; // set by the writer, from the ring it came from
+
+        Record() : sequence(0), level(LogLevel::Info), category(LogCategory::Client), time(), message(), thread(0) {}
+    };
+
+    struct Ring {
+        SpscRing<Record> records;
+        int thread;                    // numbered in order of first use
+        std::atomic<bool> abandoned;   // the thread exited; dropped once drained
+
+        explicit Ring(int id) : records(RING_CAPACITY), thread(id), abandoned(false) {}
+    };
+
+    struct Sink {
+        std::ostream *stream;
+        LogFormat format;
+        LogLevel minLevel;
+        LogLevel maxLevel;
+    };
+
+    struct ThreadRings; // the calling thread's rings, one per logger it used
+    friend struct ThreadRings;
+
+    const std::uint64_t id_; // tells loggers apart in ThreadRings, even at a reused address
+    std::atomic<int> levels_[static_cast<int>(LogCategory::Count)];
+    std::mutex sinksMutex_;
+    std::vector<Sink> sinks_;
+    std::vector<std::unique_ptr<std::ofstream>> files_;
+
+    std::mutex ringsMutex_;
+    std::vector<std::shared_ptr<Ring>> rings_; // registered, read by the writer
+    std::atomic<std::uint64_t> ringsVersion_;
+    int nextThread_;
+
+    std::atomic<std::uint64_t> sequence_; // records logged
+    std::atomic<std::uint64_t> written_;  // records written
+    std::atomic<bool> stopping_;
+    ParkingSpot pending_;   // the writer waits for records
+    ParkingSpot writable_;  // threads with a full ring wait for room
+    ParkingSpot drained_;   // flush() waits for written_
+    std::thread writer_;
+
+    Ring &threadRing();
+    void writeRecords();
+    void write(const Record &record, const Sink &sink) const;
+};
+
+// Logs the streamed expression only when the level is enabled, so a disabled record is never formatted:
+// STOMP_LOG(logger, LogLevel::Debug, LogCategory::Frame, "got " << frame);
+#define STOMP_LOG(logger, level, category, expression)                                   \
+    do {                                                                                 \
+        if ((logger).enabled(level, category)) {                                         \
+            std::ostringstream stompLogStream;                                           \
+            stompLogStream << expression;                                                \
+            (logger).log(level, category, stompLogStream.str());                         \
+        }                                                                                \
+    } while (0)
@@ -0,0 +1,202 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Counters, histograms and gauges for watching a running client. Every thread updates a shard of its
+// own, so an update takes no lock and touches no cache line another thread writes: a counter add is a
+// relaxed load and store on the calling thread's slot. Readers sum the shards (and what exited threads
+// left behind). Histograms are log-linear, HDR style: values below 16 are exact, above that each power of
+// two is split in 16 buckets, so a percentile is reported within 3% of the recorded value.
+// Metrics are registered once by name and labels; registering the same pair again returns the same
+// metric. Thread-safe.
+class MetricsRegistry
+{
+public:
+    static const std::size_t MAX_SLOTS = 8192;       // per thread shard: a counter takes one, a histogram 721
+    static const int SUB_BUCKET_BITS = 4;
+    static const int MAX_EXPONENT = 47;              // larger values count in the top bucket
+    static const std::size_t HISTOGRAM_BUCKETS = (std::size_t(1) << SUB_BUCKET_BITS) * (MAX_EXPONENT - SUB_BUCKET_BITS + 2);
+
+    // Handles are cheap to copy; a default-constructed one ignores updates
+    class Counter
+    {
+    public:
+        Counter() : registry_(nullptr), slot_(0) {}
+        void add(std::uint64_t count = 1) const;
+
+    private:
+        friend class MetricsRegistry;
+        Counter(MetricsRegistry *registry, std::size_t slot) : registry_(registry), slot_(slot) {}
+        MetricsRegistry *registry_;
+        std::size_t slot_;
+    };
+
+    // Durations, recorded in nanoseconds and reported in seconds
+    class Histogram
+    {
+    public:
+        Histogram() : registry_(nullptr), slot_(0) {}
+        void record(std::uint64_t nanoseconds) const;
+
+    private:
+        friend class MetricsRegistry;
+        Histogram(MetricsRegistry *registry, std::size_t slot) : registry_(registry), slot_(slot) {}
+        MetricsRegistry *registry_;
+        std::size_t slot_;
+    };
+
+    struct HistogramSnapshot {
+        std::uint64_t count;
+        std::uint64_t sumNanoseconds;
+        std::vector<std::uint64_t> buckets;
+
+        HistogramSnapshot() : count(0), sumNanoseconds(0), buckets() {}
+        // Counts a value: a histogram of the same shape kept by the caller, outside any registry
+        void add(std::uint64_t nanoseconds);
+        // The value at quantile q (0..1), in nanoseconds; 0 when empty
+        std::uint64_t percentile(double q) const;
+        std::uint64_t max() const { return percentile(1.0); }
+    };
+
+    MetricsRegistry();
+    ~MetricsRegistry(); // stopDumping()
+    MetricsRegistry(const MetricsRegistry &) = delete;
+    MetricsRegistry &operator=(const MetricsRegistry &) = delete;
+
+    // For code without a registry of its own
+    static MetricsRegistry &global();
+
+    // labels is Prometheus syntax without the braces, e.g. command="SEND". Throws std::length_error when
+    // the shards are full.
+    Counter counter(const std::string &name, const std::string &help, const std::string &labels = "");
+    Histogram histogram(const std::string &name, const std::string &help, const std::string &labels = "");
+    // A value read when the metrics are, by read (on the reading thread)
+    void gauge(const std::string &name, const std::string &help, std::function<double()> read,
+               const std::string &labels = "");
+
+    std::uint64_t value(const Counter &counter) const;
+    HistogramSnapshot snapshot(const Histogram &histogram) const;
+
+    // One line per metric, histograms as count, p50, p99, p99.9 and max
+    void render(std::ostream &out) const;
+    // Prometheus text exposition format; histograms become summaries
+    void renderPrometheus(std::ostream &out) const;
+    // renderPrometheus() to path, replaced atomically so a scraper never reads half a file
+    bool writePrometheus(const std::string &path) const;
+    // Writes path now and then every intervalSeconds from a background thread, until stopDumping().
+    // False (and nothing started) if path can't be written.
+    bool dumpEvery(const std::string &path, int intervalSeconds);
+    // Stops the dumps, writing path a last time. Gauges are not read after this returns.
+    void stopDumping();
+
+private:
+    enum class Kind { Counter, Histogram, Gauge };
+
+    struct Metric {
+        std::string name;
+        std::string labels;
+        std::string help;
+        Kind kind;
+        std::size_t slot;
+        std::function<double()> read;
+    };
+
+    struct Shard {
+        std::unique_ptr<std::atomic<std::uint64_t>[]> slots;
+        std::atomic<bool> abandoned; // the thread exited; folded into retired_ by the next reader
+
+        Shard() : slots(new std::atomic<std::uint64_t>[MAX_SLOTS]()), abandoned(false) {}
+    };
+
+    // The last shard the calling thread used, so an update usually skips the lookup. Plain data, so the
+    // thread-local needs no initialization guard.
+    struct ThreadCache {
+        std::uint64_t registry;
+        std::atomic<std::uint64_t> *slots;
+    };
+    static thread_local ThreadCache threadCache_;
+
+    struct ThreadShards; // the calling thread's shards, one per registry it updated
+    friend struct ThreadShards;
+
+    const std::uint64_t id_; // tells registries apart in the thread caches, even at a reused address
+    mutable std::mutex mutex_;
+    std::vector<Metric> metrics_; // in registration order
+    std::size_t usedSlots_;
+    mutable std::vector<std::shared_ptr<Shard>> shards_;
+    mutable std::vector<std::uint64_t> retired_; // totals of the shards of exited threads
+
+    std::mutex dumpMutex_;
+    std::condition_variable dumpChanged_;
+    std::string dumpPath_;
+    bool dumpStopping_;
+    std::thread dumper_;
+
+    std::atomic<std::uint64_t> *slots()
+    {
+        if (threadCache_.registry == id_)
+            return threadCache_.slots;
+        return registerThread();
+    }
+    std::atomic<std::uint64_t> *registerThread();
+    std::size_t allocate(const std::string &name, const std::string &help, const std::string &labels, Kind kind,
+                         std::size_t slots, std::function<double()> read);
+    // The sum of every shard, under mutex_
+    std::vector<std::uint64_t> collectLocked() const;
+    HistogramSnapshot snapshotLocked(const std::vector<std::uint64_t> &totals, std::size_t slot) const;
+    void dump(int intervalSeconds);
+
+    static std::size_t bucketIndex(std::uint64_t value);
+    // The middle of bucket index's range
+    static std::uint64_t bucketValue(std::size_t index);
+};
+
+inline void MetricsRegistry::Counter::add(std::uint64_t count) const
+{
+    if (registry_ == nullptr)
+        return;
+    std::atomic<std::uint64_t> &slot = registry_->slots()[slot_];
+    slot.store(slot.load(std::memory_order_relaxed) + count, std::memory_order_relaxed);
+}
+
+inline std::size_t MetricsRegistry::bucketIndex(std::uint64_t value)
+{
+    const std::uint64_t subBuckets = std::uint64_t(1) << SUB_BUCKET_BITS;
+    if (value < subBuckets)
+        return value;
+    int exponent = 63 - __builtin_clzll(value);
+    if (exponent > MAX_EXPONENT)
+        return HISTOGRAM_BUCKETS - 1;
+    std::uint64_t sub = (value >> (exponent - SUB_BUCKET_BITS)) - subBuckets;
+    return subBuckets * (exponent - SUB_BUCKET_BITS + 1) + sub;
+}
+
+inline void MetricsRegistry::Histogram::record(std::uint64_t nanoseconds) const
+{
+    if (registry_ == nullptr)
+        return;
+    std::atomic<std::uint64_t> *slots = registry_->slots() + slot_;
+    std::atomic<std::uint64_t> &bucket = slots[bucketIndex(nanoseconds)];
+    bucket.store(bucket.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    std::atomic<std::uint64_t> &sum = slots[HISTOGRAM_BUCKETS];
+    sum.store(sum.load(std::memory_order_relaxed) + nanoseconds, std::memory_order_relaxed);
+}
+
+// "850ns", "12.3us", "4.56ms" or "1.20s"
+std::string formatDuration(std::uint64_t nanoseconds);
+
+// Nanoseconds since start, for Histogram::record
+inline std::uint64_t elapsedNanoseconds(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+}
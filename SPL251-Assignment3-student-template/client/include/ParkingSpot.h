@@ -0,0 +1,75 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+// Lets threads wait for a condition published through atomics (a ring becoming readable or writable)
+// without a lock on the fast path. A waiter first spins, then yields, then parks on a condition
+// variable; notify() costs a fence and a load unless someone is parked. The spin budget adapts: it
+// grows while spinning catches the condition and shrinks when the waiter ends up yielding or parking.
+class ParkingSpot
+{
+public:
+    static const int MIN_SPINS = 16;
+    static const int MAX_SPINS = 4096;
+    static const int YIELDS = 8;
+
+    ParkingSpot() : mutex_(), wakeUp_(), parked_(0), spins_(256) {}
+    ParkingSpot(const ParkingSpot &) = delete;
+    ParkingSpot &operator=(const ParkingSpot &) = delete;
+
+    // Returns once ready() is true. ready() must only read state whose writers call notify() after it.
+    template <class Ready>
+    void wait(Ready ready)
+    {
+        int spins = spins_.load(std::memory_order_relaxed);
+        for (int i = 0; i < spins; ++i) {
+            if (ready()) {
+                if (spins < MAX_SPINS)
+                    spins_.store(spins * 2, std::memory_order_relaxed);
+                return;
+            }
+            cpuRelax();
+        }
+        if (spins > MIN_SPINS)
+            spins_.store(spins / 2, std::memory_order_relaxed);
+        for (int i = 0; i < YIELDS; ++i) {
+            if (ready())
+                return;
+            std::this_thread::yield();
+        }
+
+        std::unique_lock<std::mutex> lock(mutex_);
+        parked_.fetch_add(1, std::memory_order_relaxed);
+        // Pairs with the fence in notify(): either the notifier sees parked_ or this sees its update
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        while (!ready())
+            wakeUp_.wait(lock);
+        parked_.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    // Called after making a waiter's condition true
+    void notify()
+    {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (parked_.load(std::memory_order_relaxed) == 0)
+            return;
+        std::lock_guard<std::mutex> lock(mutex_); // a waiter between its check and its wait holds it
+        wakeUp_.notify_all();
+    }
+
+    static void cpuRelax()
+    {
+#if defined(__x86_64__) || defined(__i386__)
+        __builtin_ia32_pause();
+#endif
+    }
+
+private:
+    std::mutex mutex_;
+    std::condition_variable wakeUp_;
+    std::atomic<int> parked_;
+    std::atomic<int> spins_;
+};
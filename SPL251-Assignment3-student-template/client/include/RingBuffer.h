@@ -0,0 +1,160 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <utility>
+#include <vector>
+
+// Bounded lock-free queues for handing work between threads. Capacities are rounded up to a power of
+// two. The indices written by different sides sit on separate cache lines (padded, since C++11 new
+// does not honour over-alignment), and both sides move whole batches per atomic publish.
+// Neither blocks: pair them with a ParkingSpot to wait for items or for room.
+
+static const std::size_t RING_CACHE_LINE = 64;
+
+inline std::size_t ringCapacity(std::size_t requested)
+{
+    std::size_t capacity = 2;
+    while (capacity < requested)
+        capacity <<= 1;
+    return capacity;
+}
+
+// One producer thread, one consumer thread
+template <class T>
+class SpscRing
+{
+public:
+    explicit SpscRing(std::size_t capacity)
+        : slots_(ringCapacity(capacity)), mask_(slots_.size() - 1), pad0_(), tail_(0), headCache_(0), pad1_(),
+          head_(0), tailCache_(0), pad2_() {}
+    SpscRing(const SpscRing &) = delete;
+    SpscRing &operator=(const SpscRing &) = delete;
+
+    // Producer: moves up to count items from first in and publishes them together; returns how many fit
+    std::size_t tryPushBatch(T *first, std::size_t count)
+    {
+        std::size_t tail = tail_.load(std::memory_order_relaxed);
+        if (slots_.size() - (tail - headCache_) < count)
+            headCache_ = head_.load(std::memory_order_acquire);
+        std::size_t room = slots_.size() - (tail - headCache_);
+        std::size_t pushed = count < room ? count : room;
+        for (std::size_t i = 0; i < pushed; ++i)
+            slots_[(tail + i) & mask_] = std::move(first[i]);
+        tail_.store(tail + pushed, std::memory_order_release);
+        return pushed;
+    }
+    bool tryPush(T &item) { return tryPushBatch(&item, 1) == 1; }
+    bool full() const { return tail_.load(std::memory_order_relaxed) - head_.load(std::memory_order_acquire) == slots_.size(); }
+
+    // Consumer: appends up to max items to out and frees their slots together; returns how many
+    std::size_t popBatch(std::vector<T> &out, std::size_t max)
+    {
+        std::size_t head = head_.load(std::memory_order_relaxed);
+        if (tailCache_ == head)
+            tailCache_ = tail_.load(std::memory_order_acquire);
+        std::size_t available = tailCache_ - head;
+        std::size_t popped = max < available ? max : available;
+        for (std::size_t i = 0; i < popped; ++i) {
+            T &slot = slots_[(head + i) & mask_];
+            out.push_back(std::move(slot));
+            slot = T();
+        }
+        head_.store(head + popped, std::memory_order_release);
+        return popped;
+    }
+    bool readable() const { return tail_.load(std::memory_order_acquire) != head_.load(std::memory_order_relaxed); }
+
+    std::size_t capacity() const { return slots_.size(); }
+
+private:
+    std::vector<T> slots_;
+    std::size_t mask_;
+    char pad0_[RING_CACHE_LINE];
+    std::atomic<std::size_t> tail_; // producer side
+    std::size_t headCache_;
+    char pad1_[RING_CACHE_LINE];
+    std::atomic<std::size_t> head_; // consumer side
+    std::size_t tailCache_;
+    char pad2_[RING_CACHE_LINE];
+};
+
+// Any number of producer threads, one consumer thread. Producers claim slots by moving the tail with a
+// CAS and mark each slot published on its own, so a slow producer only holds up the items after its own.
+template <class T>
+class MpscRing
+{
+public:
+    explicit MpscRing(std::size_t capacity)
+        : slots_(new Slot[ringCapacity(capacity)]), capacity_(ringCapacity(capacity)), mask_(capacity_ - 1),
+          pad0_(), tail_(0), pad1_(), head_(0), pad2_()
+    {
+        for (std::size_t i = 0; i < capacity_; ++i)
+            slots_[i].published.store(i, std::memory_order_relaxed); // "index i - capacity was consumed"
+    }
+    MpscRing(const MpscRing &) = delete;
+    MpscRing &operator=(const MpscRing &) = delete;
+
+    // Producers: claims room for up to count items with one CAS, moves them in from first and publishes
+    // them; returns how many fit
+    std::size_t tryPushBatch(T *first, std::size_t count)
+    {
+        std::size_t tail = tail_.load(std::memory_order_relaxed);
+        std::size_t pushed;
+        do {
+            std::size_t room = capacity_ - (tail - head_.load(std::memory_order_acquire));
+            pushed = count < room ? count : room;
+            if (pushed == 0)
+                return 0;
+        } while (!tail_.compare_exchange_weak(tail, tail + pushed, std::memory_order_relaxed));
+        for (std::size_t i = 0; i < pushed; ++i) {
+            Slot &slot = slots_[(tail + i) & mask_];
+            slot.value = std::move(first[i]);
+            slot.published.store(tail + i + 1, std::memory_order_release);
+        }
+        return pushed;
+    }
+    bool tryPush(T &item) { return tryPushBatch(&item, 1) == 1; }
+    bool full() const { return tail_.load(std::memory_order_relaxed) - head_.load(std::memory_order_acquire) >= capacity_; }
+
+    // Consumer: appends up to max published items, in claim order, to out; returns how many
+    std::size_t popBatch(std::vector<T> &out, std::size_t max)
+    {
+        std::size_t head = head_.load(std::memory_order_relaxed);
+        std::size_t popped = 0;
+        for (; popped < max; ++popped) {
+            Slot &slot = slots_[(head + popped) & mask_];
+            if (slot.published.load(std::memory_order_acquire) != head + popped + 1)
+                break; // not claimed yet, or claimed and still being written
+            out.push_back(std::move(slot.value));
+            slot.value = T();
+        }
+        head_.store(head + popped, std::memory_order_release); // frees the slots for the producers
+        return popped;
+    }
+    bool readable() const
+    {
+        std::size_t head = head_.load(std::memory_order_relaxed);
+        return slots_[head & mask_].published.load(std::memory_order_acquire) == head + 1;
+    }
+
+    std::size_t capacity() const { return capacity_; }
+
+private:
+    struct Slot {
+        std::atomic<std::size_t> published; // claim index + 1 once the value is written
+        T value;
+
+        Slot() : published(0), value() {}
+    };
+
+    std::unique_ptr<Slot[]> slots_;
+    std::size_t capacity_;
+    std::size_t mask_;
+    char pad0_[RING_CACHE_LINE];
+    std::atomic<std::size_t> tail_; // next index to claim, producers
+    char pad1_[RING_CACHE_LINE];
+    std::atomic<std::size_t> head_; // next index to consume, consumer
+    char pad2_[RING_CACHE_LINE];
+};
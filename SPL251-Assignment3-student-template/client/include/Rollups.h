@@ -0,0 +1,69 @@
+#pragma once
+
+#include <map>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "../include/event.h"
+#include "../include/SummaryQuery.h"
+
+enum class RollupResolution { Hour, Day };
+
+// Report counts per (channel, city, time bucket), updated as events arrive so that rate charts cost
+// O(buckets in range) instead of O(events). Hourly and daily buckets are kept side by side, aligned to
+// the epoch (UTC), and survive logout through save()/load(). Thread-safe.
+class RollupTable
+{
+public:
+    static const int HOUR_SECONDS = 3600;
+    static const int DAY_SECONDS = 24 * 3600;
+
+    struct Row {
+        int start; // the bucket covers [start, start + bucket width)
+        SummaryCounts counts;
+
+        Row() : start(0), counts() {}
+    };
+
+    RollupTable();
+
+    void add(const Event &event);
+    // add() of every event, under one lock
+    void add(const std::vector<Event> &events);
+    // The non-empty buckets overlapping [from, to] on channel, oldest first. An empty city means every
+    // city of the channel.
+    std::vector<Row> query(const std::string &channel, const std::string &city, RollupResolution resolution,
+                           int from, int to) const;
+    void clear();
+    std::size_t bucketCount() const;
+
+    // Writes every bucket to path, through a temporary file renamed over it. Returns false on I/O errors.
+    bool save(const std::string &path) const;
+    // Adds the buckets saved at path to the table. A missing file adds nothing; returns false if the file
+    // can't be read or is not a rollup file.
+    bool load(const std::string &path);
+
+    static int bucketSeconds(RollupResolution resolution);
+
+private:
+    typedef std::map<int, SummaryCounts> Buckets; // bucket start -> counts
+    struct Series {
+        Buckets hours;
+        Buckets days;
+
+        Series() : hours(), days() {}
+        Buckets &at(RollupResolution resolution) { return resolution == RollupResolution::Hour ? hours : days; }
+        const Buckets &at(RollupResolution resolution) const {
+            return resolution == RollupResolution::Hour ? hours : days;
+        }
+    };
+
+    mutable std::mutex mutex_;
+    std::unordered_map<std::string, std::unordered_map<std::string, Series>> cities_; // channel -> city -> series
+    std::unordered_map<std::string, Series> channels_; // every city of a channel together
+
+    void addLocked(const Event &event);
+    void addLocked(const std::string &channel, const std::string &city, RollupResolution resolution, int start,
+                   const SummaryCounts &counts);
+};
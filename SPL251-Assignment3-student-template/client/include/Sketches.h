@@ -0,0 +1,132 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Fixed-memory summaries of a stream, used for live per-channel statistics.
+
+// Space-Saving heavy hitters: tracks at most `capacity` keys. A key's count never undercounts and
+// overcounts by at most its error, so any key seen more than total/capacity times is always present.
+class SpaceSaving
+{
+public:
+    struct Entry {
+        std::string key;
+        std::uint64_t count;
+        std::uint64_t error; // upper bound on how much count overestimates
+    };
+
+    explicit SpaceSaving(std::size_t capacity);
+
+    void add(const std::string &key, std::uint64_t weight = 1);
+    void clear();
+    // Tracked keys in no particular order
+    const std::vector<Entry> &entries() const { return entries_; }
+    // The k entries with the highest counts, highest first
+    std::vector<Entry> top(std::size_t k) const;
+
+private:
+    std::size_t capacity_;
+    std::vector<Entry> entries_;
+    std::unordered_map<std::string, std::size_t> slots_; // key -> index in entries_
+    std::vector<std::size_t> heap_;         // entry indexes, min-heap on count: heap_[0] is evicted next
+    std::vector<std::size_t> heapPosition_; // entry index -> position in heap_
+
+    void swapHeap(std::size_t a, std::size_t b);
+    void siftDown(std::size_t position);
+    void siftUp(std::size_t position);
+};
+
+// HyperLogLog distinct counter with 2^12 one-byte registers (4 KiB, ~1.6% standard error)
+class HyperLogLog
+{
+public:
+    static const int PRECISION = 12;
+
+    HyperLogLog();
+
+    void add(const std::string &key);
+    void addHash(std::uint64_t hash);
+    void clear();
+    double estimate() const;
+
+private:
+    std::vector<std::uint8_t> registers_;
+};
+
+// Bloom filter over 64-bit hashes: no false negatives, false positives at a rate set by its size.
+// `bits` is rounded up to a power of two; probes use double hashing derived from the one hash.
+class BloomFilter
+{
+public:
+    BloomFilter(std::size_t bits, int hashes);
+
+    void add(std::uint64_t hash);
+    bool mightContain(std::uint64_t hash) const;
+    void clear();
+    std::size_t memoryBytes() const { return words_.size() * sizeof(std::uint64_t); }
+
+private:
+    std::vector<std::uint64_t> words_;
+    std::uint64_t bitMask_;
+    int hashes_;
+};
+
+// A ring of time buckets covering the last `count` bucket widths up to the newest time seen.
+// Adding a newer time rotates the ring and resets the buckets that fell out of the window.
+template <class Bucket>
+class TimeBuckets
+{
+public:
+    TimeBuckets(int bucketSeconds, std::size_t count, const Bucket &empty)
+        : bucketSeconds_(bucketSeconds), empty_(empty), buckets_(count, empty), newest_(0), started_(false) {}
+
+    // Bucket for time, or nullptr when time is older than the window
+    Bucket *bucketFor(long long time) {
+        long long index = bucketIndex(time);
+        long long count = static_cast<long long>(buckets_.size());
+        if (!started_ || index > newest_) {
+            long long first = started_ ? std::max(newest_ + 1, index - count + 1) : index - count + 1;
+            for (long long i = first; i <= index; ++i)
+                buckets_[slot(i)] = empty_;
+            newest_ = index;
+            started_ = true;
+        } else if (index <= newest_ - count) {
+            return nullptr;
+        }
+        return &buckets_[slot(index)];
+    }
+
+    // Visit the buckets overlapping (now - seconds, now], oldest first
+    template <class Visitor>
+    void forEachWithin(long long now, long long seconds, Visitor visit) const {
+        if (!started_)
+            return;
+        long long count = static_cast<long long>(buckets_.size());
+        long long last = std::min(bucketIndex(now), newest_);
+        long long first = std::max(bucketIndex(now - seconds + 1), newest_ - count + 1);
+        for (long long i = first; i <= last; ++i)
+            visit(buckets_[slot(i)]);
+    }
+
+    long long spanSeconds() const { return static_cast<long long>(buckets_.size()) * bucketSeconds_; }
+
+private:
+    int bucketSeconds_;
+    Bucket empty_;
+    std::vector<Bucket> buckets_;
+    long long newest_;  // bucket index (time / bucketSeconds) of the newest bucket
+    bool started_;
+
+    long long bucketIndex(long long time) const {
+        long long index = time / bucketSeconds_;
+        return (time % bucketSeconds_ != 0 && time < 0) ? index - 1 : index;
+    }
+    std::size_t slot(long long index) const {
+        long long count = static_cast<long long>(buckets_.size());
+        return static_cast<std::size_t>(((index % count) + count) % count);
+    }
+};
@@ -0,0 +1,201 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include "../include/ChannelStats.h"
+#include "../include/ConnectionHandler.h"
+#include "../include/Deduplicator.h"
+#include "../include/DeliveryLatency.h"
+#include "../include/EventStore.h"
+#include "../include/KeyedThreadPool.h"
+#include "../include/Logger.h"
+#include "../include/Metrics.h"
+#include "../include/Rollups.h"
+#include "../include/StompProtocol.h"
+#include "../include/StompScript.h"
+#include "../include/SummaryCache.h"
+
+// Hooks for programs embedding the client. Each is optional and runs on the session's reader thread
+// (event on a message worker), so it should return quickly and must not call the engine's session calls.
+struct StompClientCallbacks {
+    std::function<void()> connected;                   // the server accepted the login
+    std::function<void(const Event &)> event;          // a new report was stored (not duplicates); in arrival
+                                                       // order per channel, channels concurrently
+    std::function<void(const std::string &)> error;    // an ERROR frame, in full
+    std::function<void()> disconnected;                // the session ended, by disconnect() or a lost connection
+
+    StompClientCallbacks() : connected(), event(), error(), disconnected() {}
+};
+
+struct StompClientOptions {
+    std::ostream *out; // console messages of the commands and frames, up to Info; null discards them
+    std::ostream *err; // warnings and errors
+    EventStoreOptions store;
+    StompClientCallbacks callbacks;
+    std::size_t messageWorkers; // threads decoding and storing MESSAGEs; 0 = one per hardware thread
+    bool stampReports;          // reports carry sent-at and sequence headers, for subscribers' latency command
+
+    StompClientOptions(); // std::cout and std::cerr, the store's defaults (no cold tier), stamped reports
+    StompClientOptions(const StompClientOptions &) = default; // the streams are borrowed, not owned
+    StompClientOptions &operator=(const StompClientOptions &) = default;
+};
+
+// One STOMP client: the session with the server, everything received over it and the command line.
+// This is the API of libstompclient; StompEMIClient is a loop feeding stdin to execute().
+// Engines share nothing, so several independent sessions can run in one process.
+//
+// Threading rules:
+//  - The session calls (connect ... disconnect) and execute() are made from one thread at a time, the
+//    command thread. Only it opens a session, sends frames and tears a session down (joining its
+//    reader first). The one exception is the reader flushing the frames queued during the login.
+//  - The query calls may be made from any thread.
+//  - Each session has a reader thread that only reads frames: every complete frame per wakeup. It hands
+//    their MESSAGEs to the message workers, one batch per channel, which print, decode and record the
+//    events they carry, taking each lock once per batch.
+//  - Shared between them: the atomic flags, the store, stats, rollups, cache and deduplicator (each
+//    thread-safe on its own, and written to by one message worker per channel), the session end flags (under sessionMutex_), the login queue and the
+//    socket's write side (under Session::sendMutex), the logger and the metrics.
+class StompClientEngine
+{
+public:
+    explicit StompClientEngine(const StompClientOptions &options = StompClientOptions());
+    // Drops the session without logging out, as if the process ended
+    ~StompClientEngine();
+    StompClientEngine(const StompClientEngine &) = delete;
+    StompClientEngine &operator=(const StompClientEngine &) = delete;
+
+    // Session calls. connect() opens the connection and sends CONNECT; the login completes when the
+    // server answers (callbacks.connected, isLoggedIn()). Returns false if already logged in or logging
+    // in, or if the server can't be reached.
+    // Until the answer, the other session calls queue their frames; they go out in one write right after
+    // CONNECTED, or are dropped with an error if the login fails.
+    bool connect(const std::string &host, int port, const std::string &username, const std::string &password);
+    // Waits until the pending login completes or fails. True when logged in.
+    bool awaitConnected(int timeoutMs);
+    // False when neither logged in nor logging in, already subscribed (subscribe) or not subscribed (unsubscribe)
+    bool subscribe(const std::string &channel);
+    bool unsubscribe(const std::string &channel);
+    // Sends events as reports on channel, in one write. With withReceipt the last frame asks for a receipt
+    // (see awaitReceipts). False when neither logged in nor logging in, or the send fails.
+    bool publish(const std::string &channel, const std::vector<Event> &events, bool withReceipt = false);
+    // Waits until the server has receipted every frame sent with a receipt so far (SUBSCRIBE always asks
+    // for one). The server handles a connection's frames in order, so the MESSAGEs it sent us for
+    // earlier frames have been stored by then. False on timeout or when the session ended.
+    bool awaitReceipts(int timeoutMs);
+    // Logs out: DISCONNECT, saves the rollups, ends the session and drops everything received.
+    // False when neither logged in nor logging in.
+    bool disconnect();
+
+    // Query calls
+    EventStore::Snapshot snapshot() const { return eventStore_.snapshot(); }
+    // Writes the summary of query to query.file; false if the file can't be written
+    bool writeSummary(const SummaryQuery &query);
+    std::vector<RollupTable::Row> rollup(const std::string &channel, const std::string &city,
+                                         RollupResolution resolution, int from, int to) const;
+
+    // Runs one command line, printing to the console streams. Unknown commands are ignored.
+    void execute(const std::string &line);
+    // Runs script's commands back to back, as execute() would, until the end or exit. Commands that use
+    // the session first wait for a pending login; queries first wait for the receipts of earlier frames.
+    void run(const StompScript &script);
+    // True after exit, or when the reader thread failed
+    bool shouldTerminate() const { return terminate_.load(); }
+    // True between the server's CONNECTED frame and logout or a lost connection
+    bool isLoggedIn() const { return loggedIn_.load(); }
+
+    // Everything the engine prints goes through its logger: command output (category Client), frames
+    // received (Frame), the socket (Connection) and StompProtocol (Protocol). The options' streams are its
+    // plain sinks; add more sinks or change levels before the first command.
+    Logger &logger() { return logger_; }
+    // Counters and timings of the socket, the frames, MESSAGE processing and the store; see the stats command
+    MetricsRegistry &metrics() { return metrics_; }
+
+private:
+    struct Session {
+        std::unique_ptr<ConnectionHandler> connection;
+        std::unique_ptr<StompProtocol> protocol;
+        std::string username;
+        std::unordered_map<std::string, std::string> subscriptions; // channel -> subscription id
+        std::thread reader;
+        int requestedReceipt; // the last receipt id asked for; command thread only
+        int receivedReceipt;  // the highest receipt id the server sent back; under sessionMutex_
+        bool ended;           // the reader stopped; under sessionMutex_
+        std::atomic<bool> closing; // the command thread is shutting the connection down
+        std::mutex sendMutex;      // orders writes to the socket with the flush of the login queue
+        std::atomic<bool> handshaking; // CONNECT sent and not answered yet; changed under sendMutex
+        std::string queued;        // frames sent during the handshake, '\0' terminated; under sendMutex
+        int queuedCommands;        // the calls that queued them; under sendMutex
+
+        Session() : connection(), protocol(), username(), subscriptions(), reader(), requestedReceipt(0),
+                    receivedReceipt(0), ended(false), closing(false), sendMutex(), handshaking(false), queued(),
+                    queuedCommands(0) {}
+    };
+
+    Logger logger_; // first in, last out: everything else may log
+    MetricsRegistry metrics_;
+    MetricsRegistry::Histogram decodeTime_;     // per MESSAGE
+    MetricsRegistry::Histogram insertTime_;     // per batch stored
+    MetricsRegistry::Counter eventsStored_;
+    MetricsRegistry::Counter duplicateEvents_;
+    StompClientCallbacks callbacks_;
+    std::atomic<bool> terminate_;
+    std::atomic<bool> loggedIn_;
+    std::unique_ptr<Session> session_; // command thread only
+    std::mutex sessionMutex_;
+    std::condition_variable sessionChanged_;
+    int nextSubscriptionId_;
+
+    EventStore eventStore_;       // every event per channel and user, readers use snapshots
+    SummaryCache summaryCache_;   // rendered reports of recent summaries, cleared with the store
+    StreamStats streamStats_;     // live per-channel sketches
+    RollupTable rollups_;         // hourly and daily counts per channel and city, kept per user across sessions
+    Deduplicator deduplicator_;   // content hashes of the events received
+    DeliveryLatency deliveryLatency_; // per channel, recorded by the reader as MESSAGEs arrive
+    bool stampReports_;
+    KeyedThreadPool messageWorkers_; // MESSAGE processing, keyed by channel; declared last, so it drains first
+
+    // Log one message of the commands, at Info or Warn
+    void say(const std::string &text) { logger_.log(LogLevel::Info, LogCategory::Client, text); }
+    void warn(const std::string &text) { logger_.log(LogLevel::Warn, LogCategory::Client, text); }
+    // Log a frame received, formatted only if its level is enabled
+    void logFrame(LogLevel level, const char *prefix, const std::string &frame);
+
+    void readFrames(Session *session);
+    // Reader thread: one wakeup's frames, in order
+    void handleFrames(Session &session, std::vector<std::string> &frames);
+    void handleFrame(Session &session, const std::string &frame);
+    // Message worker: prints frames (MESSAGEs of one channel), decodes their events and records the ones
+    // that are not duplicates
+    void handleMessages(const std::vector<std::string> &frames);
+    // Stops the reader and closes the connection; the command thread only
+    void endSession();
+    // True when frames can be sent: logged in, or logging in and they will be queued
+    bool canSend() const { return loggedIn_ || (session_ && session_->handshaking); }
+    // Writes frames, each '\0' terminated, or queues them while the login is pending
+    bool sendFrames(const std::string &frames);
+    // Reader thread: the login was answered; sends the queue (CONNECTED) or drops it with an error
+    void endHandshake(Session &session, bool accepted);
+    // Waits for receipt id (or a later one) or the end of the session; false on timeout
+    bool awaitReceipt(int receipt, int timeoutMs);
+
+    void login(const std::string &line);
+    void join(const std::string &line);
+    void exitChannel(const std::string &line);
+    void report(const std::string &line);
+    void summary(const std::string &line);
+    void summaryAll(const std::string &line);
+    void histogram(const std::string &line);
+    void rollup(const std::string &line);
+    void search(const std::string &line);
+    void stats(const std::string &line);
+    void latency(const std::string &line);
+    void logout();
+    void quit();
+};
@@ -1,29 +1,59 @@
 #pragma once
 
 #include "../include/ConnectionHandler.h"
+#include <chrono>
 #include <string>
 #include <map>
+#include <mutex>
 #include <vector>
 #include "../include/ConnectionHandler.h"
+#include "../include/Metrics.h"
 
 // TODO: implement the STOMP protocol
 class StompProtocol
 {
 private:
     ConnectionHandler &connectionHandler;   //ref to connection Handler
+    Logger &logger; // processServerMessage() output, category Protocol
     std::map<std::string, std::string> subscriptions; //Save subscriptions by channels
     int receiptCounter; // Unique counter for receipts
+
+    // Frames built per command, CONNECT, SEND, SUBSCRIBE, UNSUBSCRIBE and DISCONNECT
+    static const std::size_t COMMANDS = 5;
+    MetricsRegistry::Counter framesSent[COMMANDS];
+    MetricsRegistry::Counter frameBytesSent[COMMANDS];
+    MetricsRegistry::Histogram receiptRoundTrip;
+    std::mutex receiptsMutex; // the frames are built on the command thread, receipts arrive on the reader
+    std::map<int, std::chrono::steady_clock::time_point> receiptsPending; // receipt id -> when it was asked for
+    bool stamping;
+    std::string stream;                              // this session's sequence stream, random
+    std::map<std::string, std::uint64_t> sequences;  // destination -> frames sent on it
+
+    // Counts frame, '\0' included, and returns it
+    std::string counted(std::size_t command, std::string frame);
+    void requestedReceipt(int id);
 public:
-    StompProtocol(ConnectionHandler &handler);
+    // Frames are counted in metrics as they are built, which is when they are sent or queued to be
+    StompProtocol(ConnectionHandler &handler, Logger &logger = Logger::console(),
+                  MetricsRegistry &metrics = MetricsRegistry::global());
 
     std::string createConnectFrame(const std::string &host, const std::string &username, const std::string &password);
-    std::string createSendFrame(const std::string &destination, const std::string &message);
+    // withReceipt asks the server for a RECEIPT once it has handled the frame (id: lastReceipt()).
+    // When stamping, the frame also carries sent-at and sequence headers (see DeliveryLatency).
+    std::string createSendFrame(const std::string &destination, const std::string &message, bool withReceipt = false);
     std::string createSubscribeFrame(const std::string &destination, const std::string &id);
     std::string createUnsubscribeFrame(const std::string &id);
     std::string createDisconnectFrame (); //Reciept
+    // Id of the receipt requested by the last frame created with one; ids grow by one per frame
+    int lastReceipt() const { return receiptCounter; }
+    void setStamping(bool enabled) { stamping = enabled; }
+    // The server sent RECEIPT id; records its round trip. Any thread.
+    void receiptReceived(int id);
 
     void processServerMessage(const std::string &message);
 
 };
 
 std::string epochToDate(int epoch);
+// The value of header name in frame's header block, or "" when it has none
+std::string headerValue(const std::string &frame, const std::string &name);
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+#include "../include/event.h"
+
+// A command file for StompEMIClient --script: one command per line, as typed at the prompt. Blank lines
+// and lines starting with '#' are skipped. Everything is read when the script is loaded, including the
+// event files of its reports (each file once), so running it only sends frames and waits where a
+// command depends on an earlier one. See StompClientEngine::run().
+class StompScript
+{
+public:
+    enum class Kind {
+        Login,   // opens a session; later session commands wait for the server's answer
+        Session, // join, exit, logout: frames the session must be logged in to send
+        Report,  // a publish of the pre-parsed file
+        Query,   // summary, histogram, stats, latency...: read what the server sent back, so they wait for receipts
+        Other    // run as typed
+    };
+
+    struct Command {
+        Kind kind;
+        std::string line;
+        std::shared_ptr<const names_and_events> report; // Report only
+        bool receipt; // Report only: a query follows, so the last frame asks for a receipt
+
+        Command() : kind(Kind::Other), line(), report(), receipt(false) {}
+    };
+
+    StompScript();
+
+    // Reads the commands at path. Returns false with a "path:line: reason" error when the file can't be
+    // read or a report's event file can't be parsed.
+    bool load(const std::string &path, std::string &error);
+    const std::vector<Command> &commands() const { return commands_; }
+
+private:
+    std::vector<Command> commands_;
+};
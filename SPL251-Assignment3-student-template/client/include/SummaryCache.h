@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include "../include/EventStore.h"
+#include "../include/SummaryQuery.h"
+#include "../include/SummaryWriter.h"
+
+// Keeps the rendered reports of recent summaries, keyed by (channel, user, filters, format), along with
+// the series version they were rendered at. A repeated summary whose series has no new events rewrites
+// the cached bytes; when every new event sorts after the cached reports, only those are rendered and
+// appended, and the header is recomputed. Anything else renders from scratch.
+// Entries refer to events by id, so the cache must be cleared together with the store. Thread-safe.
+class SummaryCache
+{
+public:
+    static const std::size_t MAX_ENTRIES = 32;
+    static const std::size_t MAX_BYTES = 64 << 20; // rendered reports kept, least recently used go first
+
+    enum class Outcome { Rendered, Reused, Appended };
+
+    SummaryCache();
+    SummaryCache(const SummaryCache &) = delete;
+    SummaryCache &operator=(const SummaryCache &) = delete;
+
+    // Writes the summary of query over snapshot to query.file, as writeSummary would. Returns false if
+    // the file can't be written. outcome, when given, tells how much was rendered.
+    bool write(const EventStore::Snapshot &snapshot, const SummaryQuery &query, Outcome *outcome = nullptr);
+    void clear();
+
+private:
+    struct Entry {
+        bool valid;          // false until first rendered
+        std::size_t version; // snapshot.seriesVersion() the reports are up to date with
+        EventId watermark;   // snapshot.watermark() at that time
+        SummaryCounts counts;
+        std::size_t reports;
+        EventId last;        // the last report, when there is one
+        std::string body;    // every report, rendered
+        std::uint64_t lastUse;
+
+        Entry() : valid(false), version(0), watermark(0), counts(), reports(0), last(0), body(), lastUse(0) {}
+    };
+
+    std::mutex mutex_;
+    std::unordered_map<std::string, Entry> entries_;
+    std::size_t bytes_;   // sum of the bodies
+    std::uint64_t uses_;
+    SummaryWriter renderer_; // never opened, renders reports into memory
+    SummaryWriter file_;
+
+    void render(const EventStore::Snapshot &snapshot, const SummaryQuery &query, const std::vector<EventId> &ids,
+                Entry &entry);
+    void evict();
+};
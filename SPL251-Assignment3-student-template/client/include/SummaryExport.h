@@ -0,0 +1,24 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include "../include/EventStore.h"
+#include "../include/SummaryQuery.h"
+#include "../include/ThreadPool.h"
+
+struct SummaryExportResult {
+    std::size_t written;
+    std::vector<std::string> failed; // files that could not be written
+
+    SummaryExportResult() : written(0), failed() {}
+};
+
+// File name for the summary of (channel, user) in format: "channel_user.txt". '_' and the characters that
+// are not safe in a file name are escaped as %XX, so no two series share a name.
+std::string summaryFileName(const std::string &channel, const std::string &user, SummaryFormat format);
+
+// Writes one summary per (channel, user) series of snapshot into the directory filters.file (created
+// if missing), applying filters' time range, attribute filters and format to each. Every series is a
+// separate pool task; returns once all are written.
+SummaryExportResult writeAllSummaries(const EventStore::Snapshot &snapshot, const SummaryQuery &filters,
+                                      ThreadPool &pool);
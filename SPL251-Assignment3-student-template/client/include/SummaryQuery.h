@@ -0,0 +1,56 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+enum class SummaryFormat { Text, Json, Csv };
+
+// A parsed summary command:
+//   summary {channel} {user} {file} [--from TIME] [--to TIME] [--last N{s|m|h|d}]
+//           [--city NAME] [--event NAME] [--info KEY=VALUE] [--format text|json|csv]
+// TIME is epoch seconds or "DD/MM/YY HH:MM" in local time. Values with spaces go in double quotes.
+struct SummaryQuery {
+    std::string channel;
+    std::string user;
+    std::string file;
+    bool hasFrom;
+    bool hasTo;
+    int from;               // inclusive date_time bounds, only meaningful when hasFrom/hasTo
+    int to;
+    std::string city;       // empty means any
+    std::string eventName;  // empty means any
+    std::string infoKey;    // general information filter, empty means none
+    std::string infoValue;
+    SummaryFormat format;
+
+    SummaryQuery();
+
+    // True when city, event name or general information filters are set
+    bool hasAttributeFilters() const;
+    // True when the query only selects a (channel, user) series, like the original summary command
+    bool isPlain() const;
+
+    // Parses a full summary command line. On failure returns false and describes the problem in error.
+    static bool parse(const std::string &line, SummaryQuery &query, std::string &error);
+    // Parses "summary-all {directory} [options]": the same options, applied to every (channel, user) series.
+    // The directory is returned in query.file; channel and user are left empty.
+    static bool parseAll(const std::string &line, SummaryQuery &query, std::string &error);
+    // Parses "histogram {channel} {user|*} {N{s|m|h|d}} [options]" into query and the bucket width.
+    // A "*" user leaves query.user empty, meaning every user of the channel.
+    static bool parseHistogram(const std::string &line, SummaryQuery &query, int &bucketSeconds, std::string &error);
+};
+
+// The totals a summary reports in its header
+struct SummaryCounts {
+    std::size_t total;
+    std::size_t active;                 // general_information "active" is "true"
+    std::size_t forcesArrivalAtScene;   // general_information "forces_arrival_at_scene" is "true"
+
+    SummaryCounts() : total(0), active(0), forcesArrivalAtScene(0) {}
+};
+
+// Splits a command line on whitespace, keeping "double quoted" arguments together (quotes removed)
+std::vector<std::string> splitCommandArgs(const std::string &line);
+
+// Parses epoch seconds or "DD/MM/YY HH:MM" (local time). Returns false if text is neither.
+bool parseDateTime(const std::string &text, int &epoch);
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstdio>
+#include <string>
+#include <vector>
+#include "../include/event.h"
+#include "../include/SummaryQuery.h"
+
+// Builds summary output in one large in-memory buffer and hands it to the OS in a few big writes.
+// Once the buffer reaches chunkSize it is written out, so very large summaries stream in fixed-size chunks.
+class SummaryWriter
+{
+private:
+    std::FILE *file_;        // unbuffered stdio handle, we do our own buffering
+    std::string buffer_;     // pending output, flushed whenever it reaches chunkSize_
+    std::size_t chunkSize_;
+    bool ok_;                // false after the first failed write
+
+    void flushIfFull();
+
+public:
+    static const std::size_t DEFAULT_CHUNK_SIZE = 1 << 20; // 1 MiB
+
+    explicit SummaryWriter(std::size_t chunkSize = DEFAULT_CHUNK_SIZE);
+    ~SummaryWriter();
+
+    SummaryWriter(const SummaryWriter &) = delete;
+    SummaryWriter &operator=(const SummaryWriter &) = delete;
+
+    // Open (and truncate) the output file. Returns false if it can't be opened.
+    bool open(const std::string &path);
+
+    void append(const char *data, std::size_t length);
+    void append(const std::string &text);
+    void append(char ch);
+    void appendInt(long long value);
+    // Append epoch as "DD/MM/YY HH:MM" in local time
+    void appendDate(int epoch);
+    // Append text as a quoted JSON string
+    void appendJsonString(const std::string &text);
+    // Append text as a CSV field, quoted only when it contains a separator, quote or newline
+    void appendCsvField(const std::string &text);
+
+    // Hands over the pending output. A writer with no open file never writes, so this is how output
+    // is rendered into memory.
+    std::string takeBuffer();
+
+    // Write out everything buffered so far. Returns false if any write failed.
+    bool flush();
+    // Flush and close the file. Returns false if any write failed.
+    bool close();
+};
+
+// Write the summary of the events selected by query to query.file in query.format, with counts (from
+// EventStore::Snapshot::aggregate) as its header. Events must already be sorted in report order.
+// Safe to call from several threads at once.
+bool writeSummary(const SummaryQuery &query, const std::vector<const Event *> &events, const SummaryCounts &counts);
+
+// The parts writeSummary puts in a file, for callers that keep rendered reports around (SummaryCache):
+// the header, every report numbered from 1, then the trailer. Only the header depends on counts, and
+// reports rendered in several calls concatenate to the same bytes as one call.
+void appendSummaryHeader(SummaryWriter &writer, const SummaryQuery &query, const SummaryCounts &counts);
+void appendSummaryReports(SummaryWriter &writer, const SummaryQuery &query, const std::vector<const Event *> &events,
+                          long long firstReport);
+void appendSummaryTrailer(SummaryWriter &writer, const SummaryQuery &query);
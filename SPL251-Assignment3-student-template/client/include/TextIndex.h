@@ -0,0 +1,79 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Inverted index over event descriptions, fed incrementally as events arrive.
+// Text is split into runs of letters and digits and folded to lower case (ASCII; other bytes are kept
+// as part of a word). Each term keeps the ids of the documents containing it, in increasing order,
+// together with the word positions, so phrase queries can be checked without re-reading the text.
+class TextIndex
+{
+public:
+    typedef std::uint32_t DocId;
+
+    struct Hit {
+        DocId doc;
+        double score; // BM25
+    };
+
+    // Collection statistics for scoring. Filled from several indexes with addStats(), they let each
+    // index score its hits as if all documents were in one index, so the scores can be merged.
+    struct CorpusStats {
+        std::size_t docCount;
+        unsigned long long totalLength;
+        std::unordered_map<std::string, std::size_t> documentFrequency; // per query word
+
+        CorpusStats() : docCount(0), totalLength(0), documentFrequency() {}
+    };
+
+    TextIndex();
+
+    // Index text under doc. Docs must be added in increasing id order.
+    void add(DocId doc, const std::string &text);
+    // Add every document of other with offset added to its id; they must come after this index's documents
+    void append(const TextIndex &other, DocId offset);
+    void clear();
+
+    // Documents containing every term and "quoted phrase" of query, best BM25 score first.
+    // Scores use stats when given, otherwise this index's own statistics.
+    std::vector<Hit> search(const std::string &query, std::size_t limit, const CorpusStats *stats = nullptr) const;
+    // Add this index's document count, length and the frequencies of query's words to stats
+    void addStats(const std::string &query, CorpusStats &stats) const;
+    // The same for a query already split by parseQuery(), for callers going over many indexes
+    std::vector<Hit> search(const std::vector<std::vector<std::string>> &query, std::size_t limit,
+                            const CorpusStats *stats = nullptr) const;
+    void addStats(const std::vector<std::vector<std::string>> &query, CorpusStats &stats) const;
+
+    std::size_t termCount() const { return postings_.size(); }
+    std::size_t docCount() const { return docCount_; }
+    std::size_t memoryBytes() const;
+
+    // Lower-cased words of text, in order
+    static std::vector<std::string> tokenize(const std::string &text);
+    // Query clauses: each bare word is one clause, each "quoted phrase" one clause of several words
+    static std::vector<std::vector<std::string>> parseQuery(const std::string &query);
+
+private:
+    struct Postings {
+        std::vector<DocId> docs;                 // increasing
+        std::vector<std::uint32_t> offsets;      // positions of docs[i] are positions[offsets[i] .. offsets[i+1])
+        std::vector<std::uint16_t> positions;
+
+        Postings() : docs(), offsets(), positions() {}
+    };
+
+    // A query clause: one term, or a phrase of consecutive terms. Entries index the distinct term lists.
+    typedef std::vector<std::size_t> Clause;
+
+    std::unordered_map<std::string, std::uint32_t> termIds_;
+    std::vector<Postings> postings_;         // by term id
+    std::vector<std::uint16_t> docLengths_;  // words per document, by doc id
+    std::size_t docCount_;
+    unsigned long long totalLength_;
+
+    static std::uint32_t phraseFrequency(const Clause &clause, const std::vector<const Postings *> &lists,
+                                         const std::vector<std::size_t> &cursors);
+};
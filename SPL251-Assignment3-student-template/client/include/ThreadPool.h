@@ -0,0 +1,37 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of worker threads running submitted tasks in submission order.
+// The destructor finishes every queued task before joining the workers.
+class ThreadPool
+{
+public:
+    // threads == 0 uses one worker per hardware thread
+    explicit ThreadPool(std::size_t threads = 0);
+    ~ThreadPool();
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    void submit(const std::function<void()> &task);
+    // Blocks until every task submitted so far has finished
+    void wait();
+    std::size_t size() const { return workers_.size(); }
+
+private:
+    std::mutex mutex_;
+    std::condition_variable taskReady_;
+    std::condition_variable allDone_;
+    std::deque<std::function<void()>> tasks_;
+    std::size_t running_;  // tasks taken by a worker and not finished yet
+    bool stopping_;
+    std::vector<std::thread> workers_;
+
+    void work();
+};
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstdint>
 #include <string>
 #include <iostream>
 #include <map>
@@ -24,6 +25,10 @@ private:
     // map of all the general information
     std::map<std::string, std::string> general_information;
     std::string eventOwnerUser;
+    // 64-bit hash of every field above, to recognize a report received twice
+    std::uint64_t content_hash;
+
+    void update_content_hash();
 
 public:
     static void split_str(const std::string &line, char delimiter, std::vector<std::string> &lineArgs);
@@ -38,6 +43,7 @@ public:
     const std::string &get_name() const;
     int get_date_time() const;
     const std::map<std::string, std::string> &get_general_information() const;
+    std::uint64_t get_content_hash() const;
 };
 
 // an object that holds the names of the teams and a vector of events, to be returned by the parseEventsFile function
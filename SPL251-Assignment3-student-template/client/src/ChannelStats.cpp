@@ -0,0 +1,110 @@
+#include "../include/ChannelStats.h"
+#include "../include/DateFormatter.h"
+#include <cmath>
+#include <map>
+
+ChannelStats::ChannelStats() : total_(0), active_(0), newest_(0),
+                               reports_(60, WINDOW_SECONDS / 60, 0), activeReports_(60, WINDOW_SECONDS / 60, 0),
+                               windowCities_(300, WINDOW_SECONDS / 300, SpaceSaving(TOP_CAPACITY)),
+                               cities_(TOP_CAPACITY), eventNames_(TOP_CAPACITY), users_(), distinctCities_() {}
+
+void ChannelStats::add(const Event &event)
+{
+    const std::map<std::string, std::string> &info = event.get_general_information();
+    std::map<std::string, std::string>::const_iterator activeIt = info.find("active");
+    bool active = activeIt != info.end() && activeIt->second == "true";
+    long long time = event.get_date_time();
+
+    ++total_;
+    if (active)
+        ++active_;
+    if (total_ == 1 || time > newest_)
+        newest_ = time;
+
+    if (std::uint64_t *count = reports_.bucketFor(time))
+        ++*count;
+    if (active) {
+        if (std::uint64_t *count = activeReports_.bucketFor(time))
+            ++*count;
+    }
+    if (SpaceSaving *window = windowCities_.bucketFor(time))
+        window->add(event.get_city());
+    cities_.add(event.get_city());
+    eventNames_.add(event.get_name());
+    users_.add(event.getEventOwnerUser());
+    distinctCities_.add(event.get_city());
+}
+
+static void renderTop(std::ostream &out, const std::string &title, const std::vector<SpaceSaving::Entry> &entries)
+{
+    out << title << ":\n";
+    int rank = 1;
+    for (const SpaceSaving::Entry &entry : entries) {
+        out << "  " << rank++ << ". " << entry.key << ": " << entry.count;
+        if (entry.error != 0)
+            out << " (+/- " << entry.error << ")";
+        out << "\n";
+    }
+}
+
+void ChannelStats::render(std::ostream &out, std::size_t topCount) const
+{
+    std::uint64_t lastHour = 0, activeLastHour = 0;
+    reports_.forEachWithin(newest_, WINDOW_SECONDS, [&](std::uint64_t count) { lastHour += count; });
+    activeReports_.forEachWithin(newest_, WINDOW_SECONDS, [&](std::uint64_t count) { activeLastHour += count; });
+
+    // Merge the five-minute summaries of the last hour; counts stay upper bounds
+    SpaceSaving hourCities(TOP_CAPACITY * 2);
+    windowCities_.forEachWithin(newest_, WINDOW_SECONDS, [&](const SpaceSaving &window) {
+        for (const SpaceSaving::Entry &entry : window.entries())
+            hourCities.add(entry.key, entry.count);
+    });
+
+    out << "Reports: " << total_ << " (active: " << active_ << ")\n"
+        << "Newest report: " << DateFormatter::format(static_cast<int>(newest_)) << "\n"
+        << "Reports in the last hour: " << lastHour << " (active: " << activeLastHour << ")\n"
+        << "Distinct reporting users: ~" << std::llround(users_.estimate()) << "\n"
+        << "Distinct cities: ~" << std::llround(distinctCities_.estimate()) << "\n";
+    renderTop(out, "Top cities in the last hour", hourCities.top(topCount));
+    renderTop(out, "Top cities overall", cities_.top(topCount));
+    renderTop(out, "Top events overall", eventNames_.top(topCount));
+}
+
+StreamStats::StreamStats() : mutex_(), channels_() {}
+
+void StreamStats::add(const Event &event)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    channels_[event.get_channel_name()].add(event);
+}
+
+void StreamStats::add(const std::vector<Event> &events)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    ChannelStats *stats = nullptr;
+    const std::string *channel = nullptr;
+    for (const Event &event : events) {
+        if (channel == nullptr || event.get_channel_name() != *channel) {
+            channel = &event.get_channel_name();
+            stats = &channels_[*channel];
+        }
+        stats->add(event);
+    }
+}
+
+bool StreamStats::render(const std::string &channel, std::ostream &out, std::size_t topCount) const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::unordered_map<std::string, ChannelStats>::const_iterator it = channels_.find(channel);
+    if (it == channels_.end())
+        return false;
+    out << "Channel " << channel << " statistics\n";
+    it->second.render(out, topCount);
+    return true;
+}
+
+void StreamStats::clear()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    channels_.clear();
+}
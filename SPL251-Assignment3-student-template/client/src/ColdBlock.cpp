@@ -0,0 +1,94 @@
+#include "../include/ColdBlock.h"
+#include <new>
+#include <stdexcept>
+#include <unordered_map>
+#include <utility>
+#include <zlib.h>
+
+ColdBlock::ColdBlock() : strings_(), times_(), fields_(), infoEnds_(), info_(), descriptionEnds_(), descriptions_() {}
+
+std::shared_ptr<const ColdBlock> ColdBlock::compress(const EventBlock &events)
+{
+    std::shared_ptr<ColdBlock> block = std::make_shared<ColdBlock>();
+    std::size_t count = events.count();
+    std::unordered_map<std::string, std::uint32_t> ids;
+    auto intern = [&block, &ids](const std::string &value) {
+        std::pair<std::unordered_map<std::string, std::uint32_t>::iterator, bool> entry =
+            ids.insert(std::make_pair(value, static_cast<std::uint32_t>(block->strings_.size())));
+        if (entry.second)
+            block->strings_.push_back(value);
+        return entry.first->second;
+    };
+
+    block->times_.reserve(count);
+    block->fields_.reserve(count * FIELDS);
+    block->infoEnds_.reserve(count);
+    block->descriptionEnds_.reserve(count);
+    std::string descriptions;
+    for (std::size_t slot = 0; slot < count; ++slot) {
+        const Event &event = events.at(slot);
+        block->times_.push_back(event.get_date_time());
+        block->fields_.push_back(intern(event.get_channel_name()));
+        block->fields_.push_back(intern(event.getEventOwnerUser()));
+        block->fields_.push_back(intern(event.get_city()));
+        block->fields_.push_back(intern(event.get_name()));
+        for (const auto &info : event.get_general_information()) {
+            block->info_.push_back(intern(info.first));
+            block->info_.push_back(intern(info.second));
+        }
+        block->infoEnds_.push_back(static_cast<std::uint32_t>(block->info_.size()));
+        descriptions += event.get_description();
+        block->descriptionEnds_.push_back(static_cast<std::uint32_t>(descriptions.size()));
+    }
+    block->info_.shrink_to_fit();
+
+    // Fastest level: the indexer thread packs blocks while ingestion goes on, and descriptions from a
+    // handful of templates already shrink several times over
+    uLongf packedLength = compressBound(static_cast<uLong>(descriptions.size()));
+    block->descriptions_.resize(packedLength);
+    if (compress2(reinterpret_cast<Bytef *>(&block->descriptions_[0]), &packedLength,
+                  reinterpret_cast<const Bytef *>(descriptions.data()), static_cast<uLong>(descriptions.size()),
+                  Z_BEST_SPEED) != Z_OK)
+        throw std::bad_alloc(); // the only failure possible with a compressBound-sized buffer
+    block->descriptions_.resize(packedLength);
+    block->descriptions_.shrink_to_fit();
+    return block;
+}
+
+std::unique_ptr<EventBlock> ColdBlock::inflate() const
+{
+    std::string descriptions(descriptionEnds_.empty() ? 0 : descriptionEnds_.back(), '\0');
+    uLongf length = static_cast<uLongf>(descriptions.size());
+    if (!descriptions.empty() &&
+        (uncompress(reinterpret_cast<Bytef *>(&descriptions[0]), &length,
+                    reinterpret_cast<const Bytef *>(descriptions_.data()), static_cast<uLong>(descriptions_.size())) != Z_OK ||
+         length != descriptions.size()))
+        throw std::runtime_error("Corrupt cold event block");
+
+    std::unique_ptr<EventBlock> events(new EventBlock());
+    std::uint32_t infoBegin = 0, descriptionBegin = 0;
+    for (std::size_t slot = 0; slot < times_.size(); ++slot) {
+        const std::uint32_t *fields = &fields_[slot * FIELDS];
+        std::map<std::string, std::string> info;
+        for (std::uint32_t i = infoBegin; i < infoEnds_[slot]; i += 2)
+            info.insert(info.end(), std::make_pair(strings_[info_[i]], strings_[info_[i + 1]]));
+        Event event(strings_[fields[0]], strings_[fields[2]], strings_[fields[3]], times_[slot],
+                    descriptions.substr(descriptionBegin, descriptionEnds_[slot] - descriptionBegin), std::move(info));
+        event.setEventOwnerUser(strings_[fields[1]]);
+        events->append(event);
+        infoBegin = infoEnds_[slot];
+        descriptionBegin = descriptionEnds_[slot];
+    }
+    return events;
+}
+
+std::size_t ColdBlock::memoryBytes() const
+{
+    std::size_t bytes = strings_.capacity() * sizeof(std::string) + times_.capacity() * sizeof(int) +
+                        (fields_.capacity() + infoEnds_.capacity() + info_.capacity() + descriptionEnds_.capacity()) *
+                            sizeof(std::uint32_t) +
+                        descriptions_.capacity();
+    for (const std::string &value : strings_)
+        bytes += value.capacity() > 15 ? value.capacity() + 1 : 0; // short strings live inside the object
+    return bytes;
+}
@@ -1,48 +1,125 @@
 #include "../include/ConnectionHandler.h"
+#include <algorithm>
+#include <cstring>
 
 using boost::asio::ip::tcp;
 
-using std::cin;
-using std::cout;
-using std::cerr;
-using std::endl;
 using std::string;
 
-ConnectionHandler::ConnectionHandler(string host, short port) : host_(host), port_(port), io_service_(),
-                                                                socket_(io_service_) {}
+// The first line of the frames counted apart, in the order of the counters
+static const char *FRAME_COMMAND_LINES[] = {"CONNECTED\n", "MESSAGE\n", "RECEIPT\n", "ERROR\n"};
+static const char *FRAME_COMMAND_LABELS[] = {"command=\"CONNECTED\"", "command=\"MESSAGE\"", "command=\"RECEIPT\"",
+                                             "command=\"ERROR\"", "command=\"other\""};
+
+ConnectionHandler::ConnectionHandler(string host, short port, Logger &logger, MetricsRegistry &metrics)
+	: host_(host), port_(port), io_service_(), socket_(io_service_), logger_(logger), shutDown_(false), received_(),
+	  receivedStart_(0), readBuffer_(READ_CHUNK),
+	  socketReads_(metrics.counter("stomp_socket_reads_total", "Reads returning data from the server's socket.")),
+	  bytesReceived_(metrics.counter("stomp_received_bytes_total", "Bytes read from the server.")),
+	  bytesSent_(metrics.counter("stomp_sent_bytes_total", "Bytes written to the server.")),
+	  framesReceived_(), frameBytesReceived_() {
+	for (std::size_t i = 0; i < FRAME_COMMANDS; ++i) {
+		framesReceived_[i] = metrics.counter("stomp_frames_received_total", "Frames read from the server, by command.",
+		                                     FRAME_COMMAND_LABELS[i]);
+		frameBytesReceived_[i] = metrics.counter("stomp_frame_bytes_received_total",
+		                                         "Bytes of the frames read from the server, by command.",
+		                                         FRAME_COMMAND_LABELS[i]);
+	}
+}
 
 ConnectionHandler::~ConnectionHandler() {
 	close();
 }
 
 bool ConnectionHandler::connect() {
-	std::cout << "Starting connect to "
-	          << host_ << ":" << port_ << std::endl;
+	STOMP_LOG(logger_, LogLevel::Info, LogCategory::Connection, "Starting connect to " << host_ << ":" << port_);
 	try {
 		tcp::endpoint endpoint(boost::asio::ip::address::from_string(host_), port_); // the server endpoint
 		boost::system::error_code error;
 		socket_.connect(endpoint, error);
 		if (error)
 			throw boost::system::system_error(error);
+		// Frames already go out in as few writes as possible; Nagle would hold a write back until the
+		// previous one is acknowledged, which a delayed ACK turns into ~40ms
+		socket_.set_option(tcp::no_delay(true), error);
 	}
 	catch (std::exception &e) {
-		std::cerr << "Connection failed (Error: " << e.what() << ')' << std::endl;
+		STOMP_LOG(logger_, LogLevel::Error, LogCategory::Connection, "Connection failed (Error: " << e.what() << ')');
 		return false;
 	}
 	return true;
 }
 
+void ConnectionHandler::compact() {
+	// Drop what was consumed once it is most of the buffer, instead of on every frame
+	if (receivedStart_ > 0 && receivedStart_ >= received_.size() / 2) {
+		received_.erase(0, receivedStart_);
+		receivedStart_ = 0;
+	}
+}
+
+bool ConnectionHandler::receiveMore() {
+	compact();
+	boost::system::error_code error;
+	std::size_t read = socket_.read_some(boost::asio::buffer(readBuffer_), error);
+	received_.append(readBuffer_.data(), read);
+	socketReads_.add();
+	bytesReceived_.add(read);
+	if (error) {
+		if (!shutDown_)
+			STOMP_LOG(logger_, LogLevel::Error, LogCategory::Connection, "recv failed (Error: " << error.message() << ')');
+		return false;
+	}
+	return true;
+}
+
+bool ConnectionHandler::getFrames(std::vector<std::string> &frames) {
+	std::size_t scanned = 0; // unconsumed bytes already known to hold no '\0'
+	while (true) {
+		std::size_t end = received_.find('\0', receivedStart_ + scanned);
+		if (end != std::string::npos) {
+			std::size_t start = receivedStart_;
+			do {
+				countFrame(start, end);
+				frames.push_back(received_.substr(start, end - start));
+				start = end + 1;
+				end = received_.find('\0', start);
+			} while (end != std::string::npos);
+			receivedStart_ = start;
+			return true;
+		}
+		scanned = received_.size() - receivedStart_;
+		if (!receiveMore())
+			return false;
+	}
+}
+
+void ConnectionHandler::countFrame(std::size_t start, std::size_t end) {
+	std::size_t command = 0;
+	while (command + 1 < FRAME_COMMANDS &&
+	       received_.compare(start, std::strlen(FRAME_COMMAND_LINES[command]), FRAME_COMMAND_LINES[command]) != 0)
+		++command;
+	framesReceived_[command].add();
+	frameBytesReceived_[command].add(end - start + 1);
+}
+
 bool ConnectionHandler::getBytes(char bytes[], unsigned int bytesToRead) {
-	size_t tmp = 0;
+	// Bytes already buffered by getFrames() or getFrameAscii() come first
+	size_t tmp = std::min<size_t>(bytesToRead, received_.size() - receivedStart_);
+	received_.copy(bytes, tmp, receivedStart_);
+	receivedStart_ += tmp;
 	boost::system::error_code error;
 	try {
 		while (!error && bytesToRead > tmp) {
-			tmp += socket_.read_some(boost::asio::buffer(bytes + tmp, bytesToRead - tmp), error);
+			size_t read = socket_.read_some(boost::asio::buffer(bytes + tmp, bytesToRead - tmp), error);
+			bytesReceived_.add(read);
+			tmp += read;
 		}
 		if (error)
 			throw boost::system::system_error(error);
 	} catch (std::exception &e) {
-		std::cerr << "recv failed (Error: " << e.what() << ')' << std::endl;
+		if (!shutDown_)
+			STOMP_LOG(logger_, LogLevel::Error, LogCategory::Connection, "recv failed (Error: " << e.what() << ')');
 		return false;
 	}
 	return true;
@@ -53,12 +130,14 @@ bool ConnectionHandler::sendBytes(const char bytes[], int bytesToWrite) {
 	boost::system::error_code error;
 	try {
 		while (!error && bytesToWrite > tmp) {
-			tmp += socket_.write_some(boost::asio::buffer(bytes + tmp, bytesToWrite - tmp), error);
+			int written = socket_.write_some(boost::asio::buffer(bytes + tmp, bytesToWrite - tmp), error);
+			bytesSent_.add(written);
+			tmp += written;
 		}
 		if (error)
 			throw boost::system::system_error(error);
 	} catch (std::exception &e) {
-		std::cerr << "recv failed (Error: " << e.what() << ')' << std::endl;
+		STOMP_LOG(logger_, LogLevel::Error, LogCategory::Connection, "recv failed (Error: " << e.what() << ')');
 		return false;
 	}
 	return true;
@@ -74,19 +153,23 @@ bool ConnectionHandler::sendLine(std::string &line) {
 
 
 bool ConnectionHandler::getFrameAscii(std::string &frame, char delimiter) {
-	char ch;
-	// Stop when we encounter the null character.
-	// Notice that the null character is not appended to the frame string.
+	// Stop when we encounter the delimiter; it is appended unless it is the null character.
+	// Notice that null characters are never appended to the frame string.
 	try {
-		do {
-			if (!getBytes(&ch, 1)) {
+		std::size_t end;
+		while ((end = received_.find(delimiter, receivedStart_)) == std::string::npos) {
+			if (!receiveMore())
 				return false;
-			}
-			if (ch != '\0')
-				frame.append(1, ch);
-		} while (delimiter != ch);
+		}
+		if (delimiter == '\0')
+			countFrame(receivedStart_, end);
+		for (std::size_t i = receivedStart_; i <= end; ++i) {
+			if (received_[i] != '\0')
+				frame.append(1, received_[i]);
+		}
+		receivedStart_ = end + 1;
 	} catch (std::exception &e) {
-		std::cerr << "recv failed2 (Error: " << e.what() << ')' << std::endl;
+		STOMP_LOG(logger_, LogLevel::Error, LogCategory::Connection, "recv failed2 (Error: " << e.what() << ')');
 		return false;
 	}
 	return true;
@@ -103,6 +186,17 @@ void ConnectionHandler::close() {
 	try {
 		socket_.close();
 	} catch (...) {
-		std::cout << "closing failed: connection already closed" << std::endl;
+		logger_.log(LogLevel::Warn, LogCategory::Connection, "closing failed: connection already closed");
 	}
 }
+
+void ConnectionHandler::feed(const std::string &bytes) {
+	compact();
+	received_.append(bytes);
+}
+
+void ConnectionHandler::shutdown() {
+	shutDown_ = true;
+	boost::system::error_code error;
+	socket_.shutdown(tcp::socket::shutdown_both, error);
+}
@@ -0,0 +1,131 @@
+#include "../include/DateFormatter.h"
+#include <climits>
+#include <cstring>
+#include <ctime>
+
+namespace {
+
+const long long SECONDS_PER_HOUR = 3600;
+const long long SECONDS_PER_DAY = 86400;
+const int CACHE_SLOTS = 64; // direct mapped by UTC hour, power of two
+
+struct HourOffset {
+    long long hour;    // UTC hour number (epoch / 3600, floored), -1 for an empty slot
+    long offset;       // local time minus UTC in seconds, valid for the whole hour
+    bool cacheable;    // false when the offset changes inside this hour (DST switch)
+    long long localDay; // local day number dayText was rendered for
+    char dayText[9];   // "DD/MM/YY " of localDay
+};
+
+thread_local HourOffset offsetCache[CACHE_SLOTS] = {};
+thread_local bool offsetCacheReady = false;
+
+long long floorDiv(long long value, long long divisor)
+{
+    long long quotient = value / divisor;
+    if ((value % divisor) != 0 && ((value < 0) != (divisor < 0)))
+        --quotient;
+    return quotient;
+}
+
+long localOffsetAt(long long epoch)
+{
+    std::time_t time = static_cast<std::time_t>(epoch);
+    std::tm tm;
+    localtime_r(&time, &tm);
+    return tm.tm_gmtoff;
+}
+
+HourOffset &lookupHour(long long hour)
+{
+    if (!offsetCacheReady) {
+        for (int i = 0; i < CACHE_SLOTS; ++i)
+            offsetCache[i].hour = -1;
+        offsetCacheReady = true;
+    }
+    HourOffset &slot = offsetCache[hour & (CACHE_SLOTS - 1)];
+    if (slot.hour != hour) {
+        long long start = hour * SECONDS_PER_HOUR;
+        long first = localOffsetAt(start);
+        long last = localOffsetAt(start + SECONDS_PER_HOUR - 1);
+        slot.hour = hour;
+        slot.offset = first;
+        slot.cacheable = (first == last);
+        slot.localDay = LLONG_MIN;
+    }
+    return slot;
+}
+
+void putTwoDigits(char *out, int value)
+{
+    out[0] = static_cast<char>('0' + value / 10);
+    out[1] = static_cast<char>('0' + value % 10);
+}
+
+void writeDate(char *out, int day, int month, int year, int hour, int minute)
+{
+    putTwoDigits(out, day);
+    out[2] = '/';
+    putTwoDigits(out + 3, month);
+    out[5] = '/';
+    putTwoDigits(out + 6, year % 100);
+    out[8] = ' ';
+    putTwoDigits(out + 9, hour);
+    out[11] = ':';
+    putTwoDigits(out + 12, minute);
+}
+
+// Render "DD/MM/YY " for a day count since 1970-01-01 (proleptic Gregorian calendar)
+void writeDay(char *out, long long days)
+{
+    long long z = days + 719468;
+    long long era = floorDiv(z, 146097);
+    long long dayOfEra = z - era * 146097;
+    long long yearOfEra = (dayOfEra - dayOfEra / 1460 + dayOfEra / 36524 - dayOfEra / 146096) / 365;
+    long long dayOfYear = dayOfEra - (365 * yearOfEra + yearOfEra / 4 - yearOfEra / 100);
+    long long shiftedMonth = (5 * dayOfYear + 2) / 153; // March based
+    int day = static_cast<int>(dayOfYear - (153 * shiftedMonth + 2) / 5 + 1);
+    int month = static_cast<int>(shiftedMonth < 10 ? shiftedMonth + 3 : shiftedMonth - 9);
+    long long year = yearOfEra + era * 400 + (month <= 2 ? 1 : 0);
+
+    putTwoDigits(out, day);
+    out[2] = '/';
+    putTwoDigits(out + 3, month);
+    out[5] = '/';
+    putTwoDigits(out + 6, static_cast<int>(((year % 100) + 100) % 100));
+    out[8] = ' ';
+}
+
+} // namespace
+
+std::size_t DateFormatter::format(int epoch, char *out)
+{
+    HourOffset &hour = lookupHour(floorDiv(epoch, SECONDS_PER_HOUR));
+    if (!hour.cacheable) {
+        std::time_t time = epoch;
+        std::tm tm;
+        localtime_r(&time, &tm);
+        writeDate(out, tm.tm_mday, tm.tm_mon + 1, tm.tm_year + 1900, tm.tm_hour, tm.tm_min);
+        return DATE_LENGTH;
+    }
+
+    long long local = static_cast<long long>(epoch) + hour.offset;
+    long long days = floorDiv(local, SECONDS_PER_DAY);
+    int secondsOfDay = static_cast<int>(local - days * SECONDS_PER_DAY);
+    if (days != hour.localDay) { // only when the hour crosses local midnight or the slot was refilled
+        writeDay(hour.dayText, days);
+        hour.localDay = days;
+    }
+    std::memcpy(out, hour.dayText, sizeof(hour.dayText));
+    putTwoDigits(out + 9, secondsOfDay / 3600);
+    out[11] = ':';
+    putTwoDigits(out + 12, (secondsOfDay / 60) % 60);
+    return DATE_LENGTH;
+}
+
+std::string DateFormatter::format(int epoch)
+{
+    char date[DATE_LENGTH];
+    format(epoch, date);
+    return std::string(date, DATE_LENGTH);
+}
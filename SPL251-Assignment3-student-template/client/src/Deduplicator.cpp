@@ -0,0 +1,89 @@
+#include "../include/Deduplicator.h"
+
+Deduplicator::Deduplicator(std::size_t recentCapacity, std::size_t generationCapacity)
+    : mutex_(), recentCapacity_(recentCapacity), generationCapacity_(generationCapacity), recent_(), recentOrder_(),
+      recentNext_(0), current_(generationCapacity * BLOOM_BITS_PER_EVENT, BLOOM_HASHES),
+      previous_(generationCapacity * BLOOM_BITS_PER_EVENT, BLOOM_HASHES), currentCount_(0), duplicates_(0)
+{
+    recent_.reserve(recentCapacity);
+    recentOrder_.reserve(recentCapacity);
+}
+
+bool Deduplicator::seenLocked(std::uint64_t hash) const
+{
+    return recent_.count(hash) != 0 || current_.mightContain(hash) || previous_.mightContain(hash);
+}
+
+bool Deduplicator::seen(std::uint64_t hash) const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return seenLocked(hash);
+}
+
+bool Deduplicator::firstSeen(std::uint64_t hash)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return firstSeenLocked(hash);
+}
+
+void Deduplicator::firstSeen(const std::vector<std::uint64_t> &hashes, std::vector<bool> &fresh)
+{
+    fresh.resize(hashes.size());
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (std::size_t i = 0; i < hashes.size(); ++i)
+        fresh[i] = firstSeenLocked(hashes[i]);
+}
+
+bool Deduplicator::firstSeenLocked(std::uint64_t hash)
+{
+    if (seenLocked(hash)) {
+        ++duplicates_;
+        return false;
+    }
+
+    if (recentCapacity_ != 0) {
+        if (recentOrder_.size() < recentCapacity_) {
+            recentOrder_.push_back(hash);
+        } else {
+            recent_.erase(recentOrder_[recentNext_]); // still remembered by the Bloom filters
+            recentOrder_[recentNext_] = hash;
+            recentNext_ = (recentNext_ + 1) % recentCapacity_;
+        }
+        recent_.insert(hash);
+    }
+
+    if (currentCount_ == generationCapacity_) {
+        std::swap(current_, previous_);
+        current_.clear();
+        currentCount_ = 0;
+    }
+    current_.add(hash);
+    ++currentCount_;
+    return true;
+}
+
+void Deduplicator::clear()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    recent_.clear();
+    recentOrder_.clear();
+    recentNext_ = 0;
+    current_.clear();
+    previous_.clear();
+    currentCount_ = 0;
+    duplicates_ = 0;
+}
+
+std::uint64_t Deduplicator::duplicates() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return duplicates_;
+}
+
+std::size_t Deduplicator::memoryBytes() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    // unordered_set node: next pointer plus the hash, and one bucket pointer per bucket
+    return current_.memoryBytes() + previous_.memoryBytes() + recentOrder_.capacity() * sizeof(std::uint64_t) +
+           recent_.size() * (sizeof(void *) + sizeof(std::uint64_t)) + recent_.bucket_count() * sizeof(void *);
+}
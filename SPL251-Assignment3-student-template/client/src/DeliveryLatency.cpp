@@ -0,0 +1,82 @@
+#include "../include/DeliveryLatency.h"
+#include <chrono>
+#include <cstdlib>
+
+DeliveryLatency::DeliveryLatency(MetricsRegistry &metrics)
+    : mutex_(), channels_(),
+      latency_(metrics.histogram("stomp_delivery_latency_seconds",
+                                 "From the sender building a SEND to reading its MESSAGE, by the sent-at header.")),
+      missing_(metrics.counter("stomp_missing_messages_total", "Messages skipped in a sender's sequence.")),
+      late_(metrics.counter("stomp_late_messages_total", "Messages arriving after a later one of their sequence.")) {}
+
+std::int64_t DeliveryLatency::now()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+void DeliveryLatency::add(const std::string &channel, const std::string &sentAt, const std::string &sequence,
+                          std::int64_t receivedAt)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    ChannelLatency &state = channels_[channel];
+    ++state.received;
+
+    if (!sentAt.empty()) {
+        std::int64_t sent = std::strtoll(sentAt.c_str(), nullptr, 10);
+        // A sender's clock ahead of ours would give a negative latency
+        std::uint64_t latency = receivedAt > sent ? static_cast<std::uint64_t>(receivedAt - sent) : 0;
+        state.latency.add(latency);
+        latency_.record(latency);
+    }
+
+    std::size_t slash = sequence.rfind('/');
+    if (slash == std::string::npos)
+        return;
+    std::uint64_t n = std::strtoull(sequence.c_str() + slash + 1, nullptr, 10);
+    std::unordered_map<std::string, std::uint64_t>::iterator next = state.nextSequence.find(sequence.substr(0, slash));
+    if (next == state.nextSequence.end()) {
+        state.nextSequence[sequence.substr(0, slash)] = n + 1;
+    } else if (n >= next->second) {
+        state.missing += n - next->second;
+        missing_.add(n - next->second);
+        next->second = n + 1;
+    } else {
+        ++state.late;
+        late_.add();
+    }
+}
+
+void DeliveryLatency::renderChannel(const std::string &name, const ChannelLatency &channel, std::ostream &out)
+{
+    out << name << ": " << channel.received << " received";
+    if (channel.latency.count == 0) {
+        out << ", none timed";
+    } else {
+        out << ", p50 " << formatDuration(channel.latency.percentile(0.5)) << "  p99 "
+            << formatDuration(channel.latency.percentile(0.99)) << "  p99.9 "
+            << formatDuration(channel.latency.percentile(0.999)) << "  max " << formatDuration(channel.latency.max());
+    }
+    out << "; " << channel.missing << " missing, " << channel.late << " late\n";
+}
+
+bool DeliveryLatency::render(const std::string &channel, std::ostream &out) const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!channel.empty()) {
+        std::map<std::string, ChannelLatency>::const_iterator it = channels_.find(channel);
+        if (it == channels_.end())
+            return false;
+        renderChannel(it->first, it->second, out);
+        return true;
+    }
+    for (const std::pair<const std::string, ChannelLatency> &entry : channels_)
+        renderChannel(entry.first, entry.second, out);
+    return !channels_.empty();
+}
+
+void DeliveryLatency::clear()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    channels_.clear();
+}
@@ -0,0 +1,1148 @@
+#include "../include/EventStore.h"
+#include "../include/ColdBlock.h"
+#include "../include/Hash.h"
+#include <algorithm>
+#include <climits>
+#include <ctime>
+#include <deque>
+#include <iterator>
+#include <set>
+
+static const int SEQ_BITS = 29;
+static const EventId SEQ_MASK = (EventId(1) << SEQ_BITS) - 1;
+
+static EventId makeId(std::size_t shard, std::size_t seq)
+{
+    return static_cast<EventId>((shard << SEQ_BITS) | seq);
+}
+
+static std::size_t shardOf(const std::string &channel)
+{
+    return static_cast<std::size_t>(hash64(channel) % EventStore::SHARD_COUNT);
+}
+
+static bool reportOrderLess(const Event &left, const Event &right)
+{
+    if (left.get_date_time() != right.get_date_time())
+        return left.get_date_time() < right.get_date_time();
+    return left.get_name() < right.get_name();
+}
+
+// The attribute filters of query; callers have already checked the time range
+static bool matchesFilters(const Event &event, const SummaryQuery &query)
+{
+    if (!query.city.empty() && event.get_city() != query.city)
+        return false;
+    if (!query.eventName.empty() && event.get_name() != query.eventName)
+        return false;
+    if (!query.infoKey.empty()) {
+        const std::map<std::string, std::string> &info = event.get_general_information();
+        std::map<std::string, std::string>::const_iterator it = info.find(query.infoKey);
+        if (it == info.end() || it->second != query.infoValue)
+            return false;
+    }
+    return true;
+}
+
+EventStoreOptions::EventStoreOptions() : indexCity(true), indexEventName(true), indexedInfoKeys(1, "active"),
+                                         indexDescriptions(true), coldAfterSeconds(0) {}
+
+std::uint16_t StringDictionary::intern(const std::string &value)
+{
+    std::pair<std::unordered_map<std::string, std::uint16_t>::iterator, bool> entry =
+        ids.insert(std::make_pair(value, static_cast<std::uint16_t>(values.size())));
+    if (entry.second)
+        values.push_back(value);
+    return entry.first->second;
+}
+
+bool StringDictionary::find(const std::string &value, std::uint16_t &id) const
+{
+    std::unordered_map<std::string, std::uint16_t>::const_iterator it = ids.find(value);
+    if (it == ids.end())
+        return false;
+    id = it->second;
+    return true;
+}
+
+EventColumns::EventColumns() : times(), channels(), series(), cities(), names(), flags(), channelIds(),
+                               seriesIds(), cityIds(), nameIds() {}
+
+std::uint8_t EventColumns::flagsOf(const Event &event)
+{
+    const std::map<std::string, std::string> &info = event.get_general_information();
+    std::uint8_t flags = 0;
+    std::map<std::string, std::string>::const_iterator it = info.find("active");
+    if (it != info.end() && it->second == "true")
+        flags |= ACTIVE;
+    it = info.find("forces_arrival_at_scene");
+    if (it != info.end() && it->second == "true")
+        flags |= FORCES_ARRIVAL_AT_SCENE;
+    return flags;
+}
+
+std::string EventColumns::seriesKey(const std::string &channel, const std::string &user)
+{
+    std::string key;
+    key.reserve(channel.size() + 1 + user.size());
+    key.append(channel).push_back('\0');
+    return key.append(user);
+}
+
+void EventColumns::reserve(std::size_t count)
+{
+    times.reserve(count);
+    channels.reserve(count);
+    series.reserve(count);
+    cities.reserve(count);
+    names.reserve(count);
+    flags.reserve(count);
+}
+
+void EventColumns::append(const Event &event)
+{
+    times.push_back(event.get_date_time());
+    channels.push_back(channelIds.intern(event.get_channel_name()));
+    series.push_back(seriesIds.intern(seriesKey(event.get_channel_name(), event.getEventOwnerUser())));
+    cities.push_back(cityIds.intern(event.get_city()));
+    names.push_back(nameIds.intern(event.get_name()));
+    flags.push_back(flagsOf(event));
+}
+
+static void appendRemapped(std::vector<std::uint16_t> &target, StringDictionary &targetIds,
+                           const std::vector<std::uint16_t> &source, const StringDictionary &sourceIds)
+{
+    std::vector<std::uint16_t> remap(sourceIds.ids.size());
+    for (const auto &entry : sourceIds.ids)
+        remap[entry.second] = targetIds.intern(entry.first);
+    for (std::uint16_t id : source)
+        target.push_back(remap[id]);
+}
+
+void EventColumns::append(const EventColumns &other)
+{
+    times.insert(times.end(), other.times.begin(), other.times.end());
+    appendRemapped(channels, channelIds, other.channels, other.channelIds);
+    appendRemapped(series, seriesIds, other.series, other.seriesIds);
+    appendRemapped(cities, cityIds, other.cities, other.cityIds);
+    appendRemapped(names, nameIds, other.names, other.nameIds);
+    flags.insert(flags.end(), other.flags.begin(), other.flags.end());
+}
+
+std::size_t EventColumns::memoryBytes() const
+{
+    std::size_t bytes = times.capacity() * sizeof(int) + flags.capacity() +
+                        (channels.capacity() + series.capacity() + cities.capacity() + names.capacity()) *
+                            sizeof(std::uint16_t);
+    const StringDictionary *dictionaries[] = {&channelIds, &seriesIds, &cityIds, &nameIds};
+    for (const StringDictionary *dictionary : dictionaries) {
+        bytes += dictionary->ids.bucket_count() * sizeof(void *) + dictionary->values.capacity() * sizeof(std::string);
+        for (const auto &entry : dictionary->ids)
+            bytes += sizeof(void *) * 2 + sizeof(std::string) + sizeof(std::uint16_t) + entry.first.capacity() * 2;
+    }
+    return bytes;
+}
+
+EventBlock::EventBlock()
+    : storage_(new Storage[CAPACITY]), keys_(new SlotKey[CAPACITY]), count_(0), descriptions_(new Descriptions()) {}
+
+std::uint64_t EventBlock::seriesHash(const std::string &channel, const std::string &user)
+{
+    return fnv1a64(user.data(), user.size(), hash64(channel));
+}
+
+EventBlock::~EventBlock()
+{
+    std::size_t count = count_.load(std::memory_order_relaxed);
+    for (std::size_t slot = 0; slot < count; ++slot)
+        reinterpret_cast<Event *>(&storage_[slot])->~Event();
+}
+
+std::size_t EventBlock::append(const Event &event)
+{
+    std::size_t slot = count_.load(std::memory_order_relaxed);
+    if (slot == CAPACITY)
+        return CAPACITY;
+    new (&storage_[slot]) Event(event);
+    keys_[slot].series = seriesHash(event.get_channel_name(), event.getEventOwnerUser());
+    keys_[slot].dateTime = event.get_date_time();
+    keys_[slot].flags = EventColumns::flagsOf(event);
+    count_.store(slot + 1, std::memory_order_release); // readers that see the new count see the event
+    return slot;
+}
+
+// Index the slots of events from descriptions.indexed up to end; the caller holds descriptions.mutex
+static void indexSlots(const EventBlock &events, EventBlock::Descriptions &descriptions, std::size_t end)
+{
+    if (!descriptions.index)
+        descriptions.index = std::make_shared<TextIndex>();
+    for (; descriptions.indexed < end; ++descriptions.indexed) {
+        TextIndex::DocId slot = static_cast<TextIndex::DocId>(descriptions.indexed);
+        descriptions.index->add(slot, events.at(slot).get_description());
+    }
+}
+
+void EventBlock::indexDescriptions()
+{
+    std::unique_lock<std::mutex> lock(descriptions_->mutex, std::try_to_lock);
+    if (!lock)
+        return; // a reader is searching it; catch up on a later append
+    // Bounded, so the append after a long search does not pay for the whole backlog at once
+    indexSlots(*this, *descriptions_,
+               std::min(count_.load(std::memory_order_relaxed), descriptions_->indexed + CATCH_UP_SLOTS));
+}
+
+std::shared_ptr<const TextIndex> EventBlock::completeDescriptions() const
+{
+    std::lock_guard<std::mutex> lock(descriptions_->mutex);
+    indexSlots(*this, *descriptions_, count());
+    return descriptions_->index;
+}
+
+void EventBlock::releaseDescriptions() const
+{
+    std::lock_guard<std::mutex> lock(descriptions_->mutex);
+    descriptions_->index.reset();
+    descriptions_->indexed = 0;
+}
+
+void ShardView::appendSealed(const SealedBlock &block)
+{
+    if (blockCount % CHUNK_BLOCKS == 0) {
+        chunks.push_back(std::make_shared<std::vector<SealedBlock>>());
+        chunks.back()->reserve(CHUNK_BLOCKS);
+    } else if (chunks.back().use_count() != 1) {
+        chunks.back() = std::make_shared<std::vector<SealedBlock>>(*chunks.back()); // shared with published views
+    }
+    chunks.back()->push_back(block);
+    ++blockCount;
+}
+
+SealedBlock &ShardView::modifySealed(std::size_t block)
+{
+    std::shared_ptr<std::vector<SealedBlock>> &chunk = chunks[block / CHUNK_BLOCKS];
+    if (chunk.use_count() != 1)
+        chunk = std::make_shared<std::vector<SealedBlock>>(*chunk);
+    return (*chunk)[block % CHUNK_BLOCKS];
+}
+
+const Event &ShardView::at(EventSeq seq) const
+{
+    std::size_t block = seq / EventBlock::CAPACITY;
+    return (block < blockCount ? *sealed(block).events : *active).at(seq % EventBlock::CAPACITY);
+}
+
+IndexSegment::IndexSegment() : first(0), last(0), minTime(0), maxTime(0), columns(), series(), cityIndex(),
+                               nameIndex(), infoIndexes(), descriptions() {}
+
+std::shared_ptr<const IndexSegment> IndexSegment::build(const ShardView &view, std::size_t block,
+                                                        const EventStoreOptions &options)
+{
+    std::shared_ptr<IndexSegment> segment = std::make_shared<IndexSegment>();
+    const EventBlock &events = *view.sealed(block).events;
+    segment->first = static_cast<EventSeq>(block * EventBlock::CAPACITY);
+    segment->last = static_cast<EventSeq>(segment->first + events.count());
+    segment->columns.reserve(events.count());
+    for (EventSeq seq = segment->first; seq < segment->last; ++seq) {
+        const Event &event = events.at(seq - segment->first);
+        if (seq == segment->first || event.get_date_time() < segment->minTime)
+            segment->minTime = event.get_date_time();
+        if (seq == segment->first || event.get_date_time() > segment->maxTime)
+            segment->maxTime = event.get_date_time();
+        segment->columns.append(event);
+
+        segment->series[event.get_channel_name()][event.getEventOwnerUser()].push_back(seq);
+        if (options.indexCity)
+            segment->cityIndex[event.get_city()].push_back(seq);
+        if (options.indexEventName)
+            segment->nameIndex[event.get_name()].push_back(seq);
+        const std::map<std::string, std::string> &info = event.get_general_information();
+        for (const std::string &key : options.indexedInfoKeys) {
+            std::map<std::string, std::string>::const_iterator it = info.find(key);
+            if (it != info.end())
+                segment->infoIndexes[key][it->second].push_back(seq);
+        }
+    }
+    // The writer has indexed most descriptions already; block slots are the segment's doc ids
+    if (options.indexDescriptions)
+        segment->descriptions = events.completeDescriptions();
+
+    // Lists were filled in arrival order; a stable sort by report order keeps arrival as the tie-break
+    const IndexSegment &built = *segment;
+    auto byReportOrder = [&view, &built](EventSeq a, EventSeq b) {
+        int timeA = built.timeOf(a), timeB = built.timeOf(b);
+        return timeA != timeB ? timeA < timeB : view.at(a).get_name() < view.at(b).get_name();
+    };
+    for (auto &channel : segment->series) {
+        for (auto &user : channel.second)
+            std::stable_sort(user.second.begin(), user.second.end(), byReportOrder);
+    }
+    std::vector<PostingIndex *> indexes;
+    indexes.push_back(&segment->cityIndex);
+    indexes.push_back(&segment->nameIndex);
+    for (auto &infoIndex : segment->infoIndexes)
+        indexes.push_back(&infoIndex.second);
+    for (PostingIndex *index : indexes) {
+        for (auto &posting : *index)
+            std::stable_sort(posting.second.begin(), posting.second.end(), byReportOrder);
+    }
+    return segment;
+}
+
+// Merge each list of newer into the list with the same key in target (a copy of older's).
+// std::merge takes from the first range on ties, so older events stay first among equals.
+template <class Comparator>
+static void mergePostings(PostingIndex &target, const PostingIndex &newer, Comparator less)
+{
+    for (const auto &posting : newer) {
+        std::vector<EventSeq> &list = target[posting.first];
+        std::vector<EventSeq> merged;
+        merged.reserve(list.size() + posting.second.size());
+        std::merge(list.begin(), list.end(), posting.second.begin(), posting.second.end(),
+                   std::back_inserter(merged), less);
+        list.swap(merged);
+    }
+}
+
+std::shared_ptr<const IndexSegment> IndexSegment::merge(const IndexSegment &older, const IndexSegment &newer)
+{
+    std::shared_ptr<IndexSegment> segment = std::make_shared<IndexSegment>();
+    segment->first = older.first;
+    segment->last = newer.last;
+    segment->minTime = std::min(older.minTime, newer.minTime);
+    segment->maxTime = std::max(older.maxTime, newer.maxTime);
+    segment->columns.reserve(older.columns.times.size() + newer.columns.times.size());
+    segment->columns.append(older.columns);
+    segment->columns.append(newer.columns);
+    segment->series = older.series;
+    segment->cityIndex = older.cityIndex;
+    segment->nameIndex = older.nameIndex;
+    segment->infoIndexes = older.infoIndexes;
+
+    // Reads only the columns: older blocks may already be in the cold tier
+    const IndexSegment &merged = *segment;
+    auto byReportOrder = [&merged](EventSeq a, EventSeq b) {
+        int timeA = merged.timeOf(a), timeB = merged.timeOf(b);
+        return timeA != timeB ? timeA < timeB : merged.nameOf(a) < merged.nameOf(b);
+    };
+    for (const auto &channel : newer.series)
+        mergePostings(segment->series[channel.first], channel.second, byReportOrder);
+    mergePostings(segment->cityIndex, newer.cityIndex, byReportOrder);
+    mergePostings(segment->nameIndex, newer.nameIndex, byReportOrder);
+    for (const auto &infoIndex : newer.infoIndexes)
+        mergePostings(segment->infoIndexes[infoIndex.first], infoIndex.second, byReportOrder);
+    if (older.descriptions && newer.descriptions) {
+        std::shared_ptr<TextIndex> descriptions = std::make_shared<TextIndex>(*older.descriptions);
+        descriptions->append(*newer.descriptions, newer.first - older.first);
+        segment->descriptions = descriptions;
+    }
+    return segment;
+}
+
+std::size_t IndexSegment::indexMemoryBytes() const
+{
+    // Per entry: the vector's heap block plus a hash node holding the key string and the vector itself
+    const std::size_t nodeOverhead = sizeof(void *) * 2 + sizeof(std::string) + sizeof(std::vector<EventSeq>);
+    std::size_t bytes = columns.memoryBytes();
+    std::vector<const PostingIndex *> indexes;
+    indexes.push_back(&cityIndex);
+    indexes.push_back(&nameIndex);
+    for (const auto &infoIndex : infoIndexes)
+        indexes.push_back(&infoIndex.second);
+    for (const PostingIndex *index : indexes) {
+        bytes += index->bucket_count() * sizeof(void *);
+        for (const auto &posting : *index)
+            bytes += nodeOverhead + posting.first.capacity() + posting.second.capacity() * sizeof(EventSeq);
+    }
+    return bytes;
+}
+
+EventStore::EventStore(const EventStoreOptions &options)
+    : options_(std::make_shared<const EventStoreOptions>(options)), shards_(new Shard[SHARD_COUNT]), sealed_(0),
+      indexed_(0), stopping_(false), pending_(), caughtUp_(), indexer_()
+{
+    indexer_ = std::thread(&EventStore::indexBlocks, this);
+}
+
+EventStore::~EventStore()
+{
+    stopping_ = true;
+    pending_.notify();
+    indexer_.join();
+}
+
+void EventStore::insert(const Event &event)
+{
+    Shard &shard = shards_[shardOf(event.get_channel_name())];
+    std::lock_guard<std::mutex> lock(shard.writer);
+    insertLocked(shard, event);
+}
+
+void EventStore::insert(const std::vector<Event> &events)
+{
+    std::size_t begin = 0;
+    while (begin < events.size()) {
+        std::size_t shardIndex = shardOf(events[begin].get_channel_name());
+        std::size_t end = begin + 1;
+        while (end < events.size() && (events[end].get_channel_name() == events[begin].get_channel_name() ||
+                                       shardOf(events[end].get_channel_name()) == shardIndex))
+            ++end;
+        Shard &shard = shards_[shardIndex];
+        std::lock_guard<std::mutex> lock(shard.writer);
+        for (; begin < end; ++begin)
+            insertLocked(shard, events[begin]);
+    }
+}
+
+void EventStore::insertLocked(Shard &shard, const Event &event)
+{
+    // Only writers replace the view and they hold the lock, so it can be read directly here
+    const ShardView &current = *shard.view;
+    if (current.active && current.active->append(event) != EventBlock::CAPACITY) {
+        if (options_->indexDescriptions)
+            current.active->indexDescriptions();
+        return;
+    }
+
+    // Seal the full block and publish a view with a fresh one; readers holding the old view are unaffected.
+    // Indexing and packing blocks is the indexer's job, so sealing costs about as much as an append.
+    const bool sealing = current.active != nullptr;
+    std::shared_ptr<ShardView> next = std::make_shared<ShardView>(current);
+    if (sealing) {
+        SealedBlock block;
+        block.events = current.active;
+        block.newest = current.active->dateTime(0);
+        for (std::size_t slot = 1; slot < EventBlock::CAPACITY; ++slot)
+            block.newest = std::max(block.newest, current.active->dateTime(slot));
+        next->appendSealed(block);
+    }
+    next->active = std::make_shared<EventBlock>();
+    next->active->append(event);
+    if (options_->indexDescriptions)
+        next->active->indexDescriptions();
+    std::atomic_store(&shard.view, std::shared_ptr<const ShardView>(next)); // may free current
+    if (sealing) {
+        sealed_.fetch_add(1);
+        pending_.notify();
+    }
+}
+
+// The indexer thread
+void EventStore::indexBlocks()
+{
+    std::uint64_t indexed = 0;
+    while (true) {
+        pending_.wait([this, indexed]() { return sealed_.load() != indexed || stopping_.load(); });
+        if (stopping_)
+            return;
+        std::uint64_t sealed = sealed_.load();
+        for (std::size_t i = 0; i < SHARD_COUNT; ++i)
+            indexShard(shards_[i]);
+        indexed = sealed;
+        indexed_.store(indexed, std::memory_order_release);
+        caughtUp_.notify();
+    }
+}
+
+// Builds the segments of the shard's unindexed blocks and packs the aged ones, all outside the lock,
+// then publishes them in a copy of the current view, which may have gained blocks meanwhile
+void EventStore::indexShard(Shard &shard)
+{
+    std::shared_ptr<const ShardView> base;
+    std::uint64_t generation;
+    {
+        std::lock_guard<std::mutex> lock(shard.writer);
+        base = shard.view;
+        generation = shard.generation;
+    }
+    std::size_t first = base->indexedBlocks(), last = base->blockCount;
+    std::vector<std::shared_ptr<const IndexSegment>> segments(base->segments);
+    for (std::size_t block = first; block < last; ++block) {
+        segments.push_back(IndexSegment::build(*base, block, *options_));
+        while (segments.size() >= 2) {
+            const IndexSegment &older = *segments[segments.size() - 2];
+            const IndexSegment &newer = *segments.back();
+            if (older.last - older.first != newer.last - newer.first ||
+                older.last - older.first >= IndexSegment::MAX_MERGED_BLOCKS * EventBlock::CAPACITY)
+                break;
+            std::shared_ptr<const IndexSegment> merged = IndexSegment::merge(older, newer);
+            segments.pop_back();
+            segments.back() = merged;
+        }
+    }
+
+    // Pack the indexed blocks whose events have all aged past the cutoff; the indexes keep pointing at them
+    std::vector<std::pair<std::size_t, std::shared_ptr<const ColdBlock>>> packed;
+    if (options_->coldAfterSeconds > 0) {
+        long long cutoff = static_cast<long long>(std::time(nullptr)) - options_->coldAfterSeconds;
+        for (std::size_t block = 0; block < last; ++block) {
+            const SealedBlock &sealed = base->sealed(block);
+            if (sealed.events && sealed.newest < cutoff)
+                packed.push_back(std::make_pair(block, ColdBlock::compress(*sealed.events)));
+        }
+    }
+    if (first == last && packed.empty())
+        return;
+
+    {
+        std::lock_guard<std::mutex> lock(shard.writer);
+        if (shard.generation != generation)
+            return; // cleared: these blocks are gone
+        std::shared_ptr<ShardView> next = std::make_shared<ShardView>(*shard.view);
+        next->segments.swap(segments);
+        for (const std::pair<std::size_t, std::shared_ptr<const ColdBlock>> &block : packed) {
+            SealedBlock &sealed = next->modifySealed(block.first);
+            sealed.cold = block.second;
+            sealed.events.reset();
+            ++next->coldCount;
+        }
+        std::atomic_store(&shard.view, std::shared_ptr<const ShardView>(next));
+    }
+    // Their segments own the description indexes now
+    for (std::size_t block = first; block < last; ++block)
+        base->sealed(block).events->releaseDescriptions();
+}
+
+void EventStore::flush()
+{
+    std::uint64_t target = sealed_.load();
+    caughtUp_.wait([this, target]() { return indexed_.load(std::memory_order_acquire) >= target; });
+}
+
+// Inflated cold blocks live as long as the snapshot (and its copies), so references into them stay valid.
+// Each slot is published with a release store once its block is inflated.
+struct EventStore::Snapshot::ColdCache {
+    std::mutex mutex; // guards owned
+    std::vector<std::unique_ptr<std::atomic<const EventBlock *>[]>> blocks; // per shard, per sealed block
+    std::vector<std::unique_ptr<EventBlock>> owned;
+
+    ColdCache() : mutex(), blocks(), owned() {}
+};
+
+EventStore::Snapshot EventStore::snapshot() const
+{
+    Snapshot snapshot;
+    snapshot.options_ = options_;
+    snapshot.shards_.reserve(SHARD_COUNT);
+    bool anyCold = false;
+    for (std::size_t i = 0; i < SHARD_COUNT; ++i) {
+        Snapshot::Shard shard = {std::atomic_load(&shards_[i].view), 0};
+        if (shard.view->active)
+            shard.activeCount = shard.view->active->count();
+        anyCold = anyCold || shard.view->coldCount != 0;
+        snapshot.shards_.push_back(shard);
+    }
+
+    if (anyCold) {
+        snapshot.cold_ = std::make_shared<Snapshot::ColdCache>();
+        for (const Snapshot::Shard &shard : snapshot.shards_) {
+            std::size_t blocks = shard.view->blockCount;
+            snapshot.cold_->blocks.push_back(std::unique_ptr<std::atomic<const EventBlock *>[]>(
+                new std::atomic<const EventBlock *>[blocks]));
+            for (std::size_t block = 0; block < blocks; ++block)
+                snapshot.cold_->blocks.back()[block].store(nullptr, std::memory_order_relaxed);
+        }
+    }
+    return snapshot;
+}
+
+void EventStore::clear()
+{
+    for (std::size_t i = 0; i < SHARD_COUNT; ++i) {
+        std::lock_guard<std::mutex> lock(shards_[i].writer);
+        ++shards_[i].generation;
+        std::atomic_store(&shards_[i].view, std::shared_ptr<const ShardView>(std::make_shared<ShardView>()));
+    }
+}
+
+std::size_t EventStore::indexMemoryBytes() const
+{
+    std::size_t bytes = 0;
+    for (std::size_t i = 0; i < SHARD_COUNT; ++i) {
+        std::shared_ptr<const ShardView> view = std::atomic_load(&shards_[i].view);
+        for (const std::shared_ptr<const IndexSegment> &segment : view->segments)
+            bytes += segment->indexMemoryBytes();
+    }
+    return bytes;
+}
+
+static std::size_t stringHeapBytes(const std::string &text)
+{
+    return text.capacity() > 15 ? text.capacity() + 1 : 0; // short strings live inside the object
+}
+
+// Heap held by a whole block: its slots plus what each event allocates
+static std::size_t blockMemoryBytes(const EventBlock &events)
+{
+    const std::size_t mapNodeOverhead = sizeof(void *) * 4; // red-black tree node header
+    std::size_t bytes = EventBlock::CAPACITY * (sizeof(Event) + sizeof(std::uint64_t) * 2);
+    for (std::size_t slot = 0; slot < events.count(); ++slot) {
+        const Event &event = events.at(slot);
+        bytes += stringHeapBytes(event.get_channel_name()) + stringHeapBytes(event.get_city()) +
+                 stringHeapBytes(event.get_name()) + stringHeapBytes(event.get_description()) +
+                 stringHeapBytes(event.getEventOwnerUser());
+        for (const auto &info : event.get_general_information())
+            bytes += mapNodeOverhead + sizeof(info) + stringHeapBytes(info.first) + stringHeapBytes(info.second);
+    }
+    return bytes;
+}
+
+void EventStore::eventMemoryBytes(std::size_t &hot, std::size_t &cold) const
+{
+    hot = 0;
+    cold = 0;
+    for (std::size_t i = 0; i < SHARD_COUNT; ++i) {
+        std::shared_ptr<const ShardView> view = std::atomic_load(&shards_[i].view);
+        for (std::size_t block = 0; block < view->blockCount; ++block) {
+            const SealedBlock &sealed = view->sealed(block);
+            if (sealed.events)
+                hot += blockMemoryBytes(*sealed.events);
+            else
+                cold += sealed.cold->memoryBytes();
+        }
+        if (view->active)
+            hot += blockMemoryBytes(*view->active);
+    }
+}
+
+EventStore::Snapshot::Snapshot() : options_(), shards_(), cold_() {}
+
+const Event &EventStore::Snapshot::get(EventId id) const
+{
+    return event(id >> SEQ_BITS, id & SEQ_MASK);
+}
+
+const Event &EventStore::Snapshot::event(std::size_t shard, EventSeq seq) const
+{
+    const ShardView &view = *shards_[shard].view;
+    std::size_t block = seq / EventBlock::CAPACITY;
+    if (block < view.blockCount && !view.sealed(block).events)
+        return inflated(shard, block).at(seq % EventBlock::CAPACITY);
+    return view.at(seq);
+}
+
+const EventBlock &EventStore::Snapshot::inflated(std::size_t shard, std::size_t block) const
+{
+    std::atomic<const EventBlock *> &slot = cold_->blocks[shard][block];
+    const EventBlock *events = slot.load(std::memory_order_acquire);
+    if (events != nullptr)
+        return *events;
+
+    // Inflate outside the lock so threads reading different blocks do not wait on each other;
+    // if two threads race for the same block, the loser's copy is dropped
+    std::unique_ptr<EventBlock> fresh = shards_[shard].view->sealed(block).cold->inflate();
+    std::lock_guard<std::mutex> lock(cold_->mutex);
+    events = slot.load(std::memory_order_relaxed);
+    if (events == nullptr) {
+        events = fresh.get();
+        cold_->owned.push_back(std::move(fresh));
+        slot.store(events, std::memory_order_release);
+    }
+    return *events;
+}
+
+template <class Visitor>
+void EventStore::Snapshot::forEachUnindexed(const Shard &shard, Visitor visit) const
+{
+    const ShardView &view = *shard.view;
+    for (std::size_t block = view.indexedBlocks(); block < view.blockCount; ++block)
+        visit(*view.sealed(block).events, static_cast<EventSeq>(block * EventBlock::CAPACITY), EventBlock::CAPACITY);
+    if (shard.activeCount != 0)
+        visit(*view.active, static_cast<EventSeq>(view.blockCount * EventBlock::CAPACITY), shard.activeCount);
+}
+
+std::size_t EventStore::Snapshot::size() const
+{
+    std::size_t size = 0;
+    for (const Shard &shard : shards_)
+        size += shard.view->blockCount * EventBlock::CAPACITY + shard.activeCount;
+    return size;
+}
+
+bool EventStore::Snapshot::hasChannel(const std::string &channel) const
+{
+    if (shards_.empty())
+        return false;
+    const Shard &shard = shards_[shardOf(channel)];
+    for (const std::shared_ptr<const IndexSegment> &segment : shard.view->segments) {
+        if (segment->series.find(channel) != segment->series.end())
+            return true;
+    }
+    bool found = false;
+    forEachUnindexed(shard, [&channel, &found](const EventBlock &block, EventSeq, std::size_t count) {
+        for (std::size_t slot = 0; slot < count && !found; ++slot)
+            found = block.at(slot).get_channel_name() == channel;
+    });
+    return found;
+}
+
+std::vector<std::pair<std::string, std::string>> EventStore::Snapshot::series() const
+{
+    std::set<std::pair<std::string, std::string>> found;
+    for (const Shard &shard : shards_) {
+        for (const std::shared_ptr<const IndexSegment> &segment : shard.view->segments) {
+            for (const auto &channel : segment->series) {
+                for (const auto &user : channel.second)
+                    found.insert(std::make_pair(channel.first, user.first));
+            }
+        }
+        forEachUnindexed(shard, [&found](const EventBlock &block, EventSeq, std::size_t count) {
+            for (std::size_t slot = 0; slot < count; ++slot) {
+                const Event &event = block.at(slot);
+                found.insert(std::make_pair(event.get_channel_name(), event.getEventOwnerUser()));
+            }
+        });
+    }
+    return std::vector<std::pair<std::string, std::string>>(found.begin(), found.end());
+}
+
+bool EventStore::Snapshot::reportOrderLess(EventId a, EventId b) const
+{
+    const Event &left = get(a);
+    const Event &right = get(b);
+    if (::reportOrderLess(left, right))
+        return true;
+    if (::reportOrderLess(right, left))
+        return false;
+    return a < b;
+}
+
+std::size_t EventStore::Snapshot::seriesVersion(const std::string &channel, const std::string &user) const
+{
+    if (shards_.empty())
+        return 0;
+    const Shard &shard = shards_[shardOf(channel)];
+    std::size_t count = 0;
+    for (const std::shared_ptr<const IndexSegment> &segment : shard.view->segments) {
+        auto channelIt = segment->series.find(channel);
+        if (channelIt == segment->series.end())
+            continue;
+        auto userIt = channelIt->second.find(user);
+        if (userIt != channelIt->second.end())
+            count += userIt->second.size();
+    }
+    std::uint64_t series = EventBlock::seriesHash(channel, user);
+    forEachUnindexed(shard, [&](const EventBlock &block, EventSeq, std::size_t blockCount) {
+        for (std::size_t slot = 0; slot < blockCount; ++slot) {
+            if (block.seriesHash(slot) != series)
+                continue;
+            const Event &event = block.at(slot);
+            if (event.get_channel_name() == channel && event.getEventOwnerUser() == user)
+                ++count;
+        }
+    });
+    return count;
+}
+
+EventId EventStore::Snapshot::watermark(const std::string &channel) const
+{
+    if (shards_.empty())
+        return 0;
+    std::size_t shardIndex = shardOf(channel);
+    const Shard &shard = shards_[shardIndex];
+    return makeId(shardIndex, shard.view->blockCount * EventBlock::CAPACITY + shard.activeCount);
+}
+
+void EventStore::Snapshot::selectSegment(std::size_t shard, const IndexSegment &segment, const SummaryQuery &query,
+                                         EventSeq since, std::vector<TimedId> &selected) const
+{
+    if (segment.last <= since)
+        return;
+    if ((query.hasFrom && segment.maxTime < query.from) || (query.hasTo && segment.minTime > query.to))
+        return;
+    auto channelIt = segment.series.find(query.channel);
+    if (channelIt == segment.series.end())
+        return;
+    auto userIt = channelIt->second.find(query.user);
+    if (userIt == channelIt->second.end())
+        return;
+
+    // Lists are sorted by date_time first, so a time range is a contiguous slice
+    typedef std::vector<EventSeq>::const_iterator SeqIterator;
+    auto timeSlice = [&](const std::vector<EventSeq> &list, SeqIterator &first, SeqIterator &last) {
+        first = list.begin();
+        last = list.end();
+        if (query.hasFrom) {
+            first = std::lower_bound(first, last, query.from,
+                [&segment](EventSeq seq, int time) { return segment.timeOf(seq) < time; });
+        }
+        if (query.hasTo) {
+            last = std::upper_bound(first, last, query.to,
+                [&segment](int time, EventSeq seq) { return time < segment.timeOf(seq); });
+        }
+    };
+
+    SeqIterator first, last;
+    timeSlice(userIt->second, first, last);
+
+    // Drive the scan from the shortest candidate list: the series slice or an indexed posting list.
+    // Every list is in report order, so the output is too; the remaining filters are checked per event.
+    bool fromSeries = true;
+    std::vector<const std::vector<EventSeq> *> postings;
+    const EventStoreOptions &options = *options_;
+    if (!query.city.empty() && options.indexCity) {
+        PostingIndex::const_iterator it = segment.cityIndex.find(query.city);
+        if (it == segment.cityIndex.end())
+            return;
+        postings.push_back(&it->second);
+    }
+    if (!query.eventName.empty() && options.indexEventName) {
+        PostingIndex::const_iterator it = segment.nameIndex.find(query.eventName);
+        if (it == segment.nameIndex.end())
+            return;
+        postings.push_back(&it->second);
+    }
+    if (!query.infoKey.empty() && std::find(options.indexedInfoKeys.begin(), options.indexedInfoKeys.end(),
+                                            query.infoKey) != options.indexedInfoKeys.end()) {
+        auto indexIt = segment.infoIndexes.find(query.infoKey);
+        if (indexIt == segment.infoIndexes.end())
+            return;
+        PostingIndex::const_iterator it = indexIt->second.find(query.infoValue);
+        if (it == indexIt->second.end())
+            return;
+        postings.push_back(&it->second);
+    }
+    for (const std::vector<EventSeq> *posting : postings) {
+        SeqIterator postingFirst, postingLast;
+        timeSlice(*posting, postingFirst, postingLast);
+        if (postingLast - postingFirst < last - first) {
+            first = postingFirst;
+            last = postingLast;
+            fromSeries = false;
+        }
+    }
+
+    for (SeqIterator it = first; it != last; ++it) {
+        if (*it < since)
+            continue;
+        const Event &event = this->event(shard, *it);
+        if (!fromSeries && (event.get_channel_name() != query.channel || event.getEventOwnerUser() != query.user))
+            continue;
+        if (!query.hasAttributeFilters() || matchesFilters(event, query)) {
+            TimedId found = {segment.timeOf(*it), makeId(shard, *it)};
+            selected.push_back(found);
+        }
+    }
+}
+
+std::vector<EventId> EventStore::Snapshot::select(const SummaryQuery &query) const
+{
+    return selectFrom(query, 0);
+}
+
+std::vector<EventId> EventStore::Snapshot::selectSince(const SummaryQuery &query, EventId watermark) const
+{
+    return selectFrom(query, watermark & SEQ_MASK);
+}
+
+// select(query), skipping the events with sequence numbers below since
+std::vector<EventId> EventStore::Snapshot::selectFrom(const SummaryQuery &query, EventSeq since) const
+{
+    std::vector<EventId> ids;
+    if (shards_.empty())
+        return ids;
+    std::size_t shardIndex = shardOf(query.channel);
+    const Shard &shard = shards_[shardIndex];
+
+    // Each segment yields a run in report order; runs[i] is where run i starts in selected
+    std::vector<TimedId> selected;
+    std::vector<std::size_t> runs;
+    for (const std::shared_ptr<const IndexSegment> &segment : shard.view->segments) {
+        runs.push_back(selected.size());
+        selectSegment(shardIndex, *segment, query, since, selected);
+    }
+    runs.push_back(selected.size());
+
+    // The active block and the sealed blocks waiting for the indexer have no indexes yet; they are few
+    std::uint64_t series = EventBlock::seriesHash(query.channel, query.user);
+    forEachUnindexed(shard, [&](const EventBlock &block, EventSeq first, std::size_t count) {
+        for (std::size_t slot = since > first ? since - first : 0; slot < count; ++slot) {
+            int time = block.dateTime(slot);
+            if (block.seriesHash(slot) != series || (query.hasFrom && time < query.from) ||
+                (query.hasTo && time > query.to))
+                continue;
+            const Event &event = block.at(slot);
+            if (event.get_channel_name() == query.channel && event.getEventOwnerUser() == query.user &&
+                matchesFilters(event, query)) {
+                TimedId found = {time, makeId(shardIndex, first + slot)};
+                selected.push_back(found);
+            }
+        }
+    });
+
+    // The unindexed run is in arrival order; then merge neighbouring runs until one is left
+    auto less = [this](const TimedId &a, const TimedId &b) {
+        return a.time != b.time ? a.time < b.time : reportOrderLess(a.id, b.id);
+    };
+    std::sort(selected.begin() + runs.back(), selected.end(), less);
+    runs.push_back(selected.size());
+    while (runs.size() > 2) {
+        std::vector<std::size_t> merged;
+        for (std::size_t i = 0; i + 2 < runs.size(); i += 2) {
+            std::inplace_merge(selected.begin() + runs[i], selected.begin() + runs[i + 1],
+                               selected.begin() + runs[i + 2], less);
+            merged.push_back(runs[i]);
+        }
+        if (runs.size() % 2 == 0)
+            merged.push_back(runs[runs.size() - 2]); // odd run count: the last run waits for the next pass
+        merged.push_back(runs.back());
+        runs.swap(merged);
+    }
+
+    ids.reserve(selected.size());
+    for (const TimedId &found : selected)
+        ids.push_back(found.id);
+    return ids;
+}
+
+// The per-batch kernels below run a fixed EventBlock::CAPACITY rows over restrict-qualified arrays,
+// which is what lets GCC vectorize them at -O2
+static const std::size_t BATCH = EventBlock::CAPACITY;
+
+static void matchRows(const std::uint16_t *__restrict__ keys, std::uint16_t key, const int *__restrict__ times,
+                      int from, int to, const std::uint8_t *__restrict__ flags, std::uint8_t flagMask,
+                      std::uint8_t *__restrict__ match)
+{
+    for (std::size_t i = 0; i < BATCH; ++i)
+        match[i] = (keys[i] == key) & (times[i] >= from) & (times[i] <= to) & ((flags[i] & flagMask) == flagMask);
+}
+
+static void keepEqual(const std::uint16_t *__restrict__ values, std::uint16_t value, std::uint8_t *__restrict__ match)
+{
+    for (std::size_t i = 0; i < BATCH; ++i)
+        match[i] &= values[i] == value;
+}
+
+template <class Visitor>
+void EventStore::Snapshot::scanColumns(const SummaryQuery &query, Visitor visit) const
+{
+    if (shards_.empty())
+        return;
+    const std::size_t shardIndex = shardOf(query.channel);
+    const Shard &shard = shards_[shardIndex];
+    const ShardView &view = *shard.view;
+    const bool anyUser = query.user.empty();
+    const int from = query.hasFrom ? query.from : INT_MIN;
+    const int to = query.hasTo ? query.to : INT_MAX;
+
+    // The two summary flags are columns; any other general information filter is checked on the event
+    std::uint8_t flagMask = 0;
+    bool checkInfo = false;
+    if (!query.infoKey.empty()) {
+        if (query.infoKey == "active" && query.infoValue == "true")
+            flagMask = EventColumns::ACTIVE;
+        else if (query.infoKey == "forces_arrival_at_scene" && query.infoValue == "true")
+            flagMask = EventColumns::FORCES_ARRIVAL_AT_SCENE;
+        else
+            checkInfo = true;
+    }
+
+    std::uint8_t match[BATCH];
+    const std::string seriesKey = EventColumns::seriesKey(query.channel, query.user);
+    for (const std::shared_ptr<const IndexSegment> &segment : view.segments) {
+        if (segment->maxTime < from || segment->minTime > to)
+            continue;
+        const EventColumns &columns = segment->columns;
+        std::uint16_t key, city = 0, name = 0;
+        if (!(anyUser ? columns.channelIds.find(query.channel, key) : columns.seriesIds.find(seriesKey, key)))
+            continue;
+        if ((!query.city.empty() && !columns.cityIds.find(query.city, city)) ||
+            (!query.eventName.empty() && !columns.nameIds.find(query.eventName, name)))
+            continue;
+
+        // Segments cover whole sealed blocks, so the columns split into full batches
+        const std::vector<std::uint16_t> &keys = anyUser ? columns.channels : columns.series;
+        for (std::size_t begin = 0; begin < columns.times.size(); begin += BATCH) {
+            const int *times = &columns.times[begin];
+            const std::uint8_t *flags = &columns.flags[begin];
+            matchRows(&keys[begin], key, times, from, to, flags, flagMask, match);
+            if (!query.city.empty())
+                keepEqual(&columns.cities[begin], city, match);
+            if (!query.eventName.empty())
+                keepEqual(&columns.names[begin], name, match);
+            if (checkInfo) {
+                for (std::size_t i = 0; i < BATCH; ++i) {
+                    if (match[i] != 0 && !matchesFilters(event(shardIndex, segment->first + begin + i), query))
+                        match[i] = 0;
+                }
+            }
+            visit(match, times, flags);
+        }
+    }
+
+    // Unindexed blocks have no columns yet, but their slot keys hold the time and flags; the rows past
+    // the active block's count are padding that never matches
+    std::uint64_t series = EventBlock::seriesHash(query.channel, query.user);
+    int times[BATCH];
+    std::uint8_t flags[BATCH];
+    forEachUnindexed(shard, [&](const EventBlock &block, EventSeq, std::size_t count) {
+        for (std::size_t slot = 0; slot < BATCH; ++slot) {
+            bool matched = false;
+            times[slot] = 0;
+            flags[slot] = 0;
+            if (slot < count) {
+                times[slot] = block.dateTime(slot);
+                flags[slot] = block.flags(slot);
+                matched = (anyUser || block.seriesHash(slot) == series) && times[slot] >= from && times[slot] <= to &&
+                          (flags[slot] & flagMask) == flagMask;
+            }
+            if (matched) {
+                const Event &event = block.at(slot);
+                matched = event.get_channel_name() == query.channel &&
+                          (anyUser || event.getEventOwnerUser() == query.user) && matchesFilters(event, query);
+            }
+            match[slot] = matched;
+        }
+        visit(match, times, flags);
+    });
+}
+
+SummaryCounts EventStore::Snapshot::aggregate(const SummaryQuery &query) const
+{
+    SummaryCounts counts;
+    scanColumns(query, [&counts](const std::uint8_t *match, const int *, const std::uint8_t *flags) {
+        unsigned total = 0, active = 0, forces = 0;
+        for (std::size_t i = 0; i < BATCH; ++i) {
+            total += match[i];
+            active += match[i] & flags[i]; // ACTIVE is bit 0
+            forces += match[i] & (flags[i] >> 1);
+        }
+        counts.total += total;
+        counts.active += active;
+        counts.forcesArrivalAtScene += forces;
+    });
+    return counts;
+}
+
+static long long bucketOf(int time, int bucketSeconds)
+{
+    long long index = time / bucketSeconds;
+    return (time % bucketSeconds != 0 && time < 0) ? index - 1 : index;
+}
+
+bool EventStore::Snapshot::histogram(const SummaryQuery &query, int bucketSeconds,
+                                     std::vector<HistogramBucket> &buckets) const
+{
+    buckets.clear();
+    if (bucketSeconds <= 0)
+        return false;
+
+    // First pass finds the matching time span, the second counts into dense buckets
+    int low = INT_MAX, high = INT_MIN;
+    scanColumns(query, [&low, &high](const std::uint8_t *match, const int *times, const std::uint8_t *) {
+        int batchLow = INT_MAX, batchHigh = INT_MIN; // locals: low and high could alias times
+        for (std::size_t i = 0; i < BATCH; ++i) {
+            int keep = -static_cast<int>(match[i]); // all ones for matching rows, masks instead of branches
+            int time = times[i];
+            int lowCandidate = (time & keep) | (INT_MAX & ~keep);
+            int highCandidate = (time & keep) | (INT_MIN & ~keep);
+            batchLow = lowCandidate < batchLow ? lowCandidate : batchLow;
+            batchHigh = highCandidate > batchHigh ? highCandidate : batchHigh;
+        }
+        low = std::min(low, batchLow);
+        high = std::max(high, batchHigh);
+    });
+    if (low > high)
+        return true;
+    long long first = bucketOf(low, bucketSeconds);
+    long long span = bucketOf(high, bucketSeconds) - first + 1;
+    const long long origin = first * bucketSeconds;
+    if (span > static_cast<long long>(MAX_HISTOGRAM_BUCKETS) || high - origin > static_cast<long long>(UINT32_MAX))
+        return false;
+
+    buckets.resize(static_cast<std::size_t>(span));
+    for (std::size_t i = 0; i < buckets.size(); ++i)
+        buckets[i].start = static_cast<int>(origin + static_cast<long long>(i) * bucketSeconds);
+    // Gather the matching rows without branching, then bucket only those
+    scanColumns(query, [&buckets, origin, bucketSeconds](const std::uint8_t *match, const int *times,
+                                                          const std::uint8_t *flags) {
+        std::uint16_t rows[BATCH];
+        std::size_t matched = 0;
+        for (std::size_t i = 0; i < BATCH; ++i) {
+            rows[matched] = static_cast<std::uint16_t>(i);
+            matched += match[i];
+        }
+        for (std::size_t j = 0; j < matched; ++j) {
+            std::size_t row = rows[j];
+            // Checked above: offsets fit 32 bits, and 32-bit division is much cheaper
+            std::uint32_t offset = static_cast<std::uint32_t>(times[row] - origin);
+            SummaryCounts &counts = buckets[offset / static_cast<std::uint32_t>(bucketSeconds)].counts;
+            ++counts.total;
+            counts.active += flags[row] & EventColumns::ACTIVE;
+            counts.forcesArrivalAtScene += (flags[row] & EventColumns::FORCES_ARRIVAL_AT_SCENE) >> 1;
+        }
+    });
+    return true;
+}
+
+std::vector<EventStore::Snapshot::SearchHit> EventStore::Snapshot::search(const std::string &text,
+                                                                          std::size_t limit) const
+{
+    std::vector<SearchHit> hits;
+    if (limit == 0 || shards_.empty() || !options_->indexDescriptions)
+        return hits;
+
+    // Segments carry their own index. Unindexed blocks carry the one their writer keeps, locked until the
+    // query is done; slots it does not cover yet get a per-query index, and slots the writer added after
+    // this snapshot are skipped (they may still weigh a little in the statistics).
+    struct Source {
+        const TextIndex *index;
+        EventId base;              // id of doc 0
+        TextIndex::DocId visible;  // docs from here on are not in the snapshot
+        std::size_t hidden;        // how many of those the index holds
+    };
+    std::vector<Source> sources;
+    std::vector<std::unique_lock<std::mutex>> locks;
+    std::deque<TextIndex> tails;
+    for (std::size_t i = 0; i < shards_.size(); ++i) {
+        for (const std::shared_ptr<const IndexSegment> &segment : shards_[i].view->segments) {
+            Source source = {segment->descriptions.get(), makeId(i, segment->first), UINT32_MAX, 0};
+            sources.push_back(source);
+        }
+        forEachUnindexed(shards_[i], [&](const EventBlock &block, EventSeq first, std::size_t count) {
+            EventBlock::Descriptions &descriptions = block.descriptions();
+            locks.push_back(std::unique_lock<std::mutex>(descriptions.mutex));
+            TextIndex::DocId visible = static_cast<TextIndex::DocId>(count);
+            std::size_t indexed = descriptions.index ? descriptions.indexed : 0;
+            if (indexed != 0) {
+                Source source = {descriptions.index.get(), makeId(i, first), visible,
+                                 indexed > count ? indexed - count : 0};
+                sources.push_back(source);
+            }
+            if (indexed < count) {
+                tails.push_back(TextIndex());
+                for (std::size_t slot = indexed; slot < count; ++slot)
+                    tails.back().add(static_cast<TextIndex::DocId>(slot), block.at(slot).get_description());
+                Source source = {&tails.back(), makeId(i, first), visible, 0};
+                sources.push_back(source);
+            }
+        });
+    }
+
+    // Score every index against the statistics of the whole snapshot so the scores can be merged
+    std::vector<std::vector<std::string>> query = TextIndex::parseQuery(text);
+    TextIndex::CorpusStats stats;
+    for (const Source &source : sources)
+        source.index->addStats(query, stats);
+    for (const auto &word : stats.documentFrequency) {
+        if (word.second == 0)
+            return hits; // every word is required
+    }
+    for (const Source &source : sources) {
+        for (const TextIndex::Hit &hit : source.index->search(query, limit + source.hidden, &stats)) {
+            if (hit.doc < source.visible) {
+                SearchHit found = {source.base + hit.doc, hit.score};
+                hits.push_back(found);
+            }
+        }
+    }
+    locks.clear();
+
+    auto better = [](const SearchHit &a, const SearchHit &b) {
+        return a.score != b.score ? a.score > b.score : a.id > b.id; // newer first on ties
+    };
+    std::size_t keep = std::min(limit, hits.size());
+    std::partial_sort(hits.begin(), hits.begin() + keep, hits.end(), better);
+    hits.erase(hits.begin() + keep, hits.end());
+    return hits;
+}
@@ -0,0 +1,83 @@
+#include "../include/KeyedThreadPool.h"
+#include <algorithm>
+
+KeyedThreadPool::KeyedThreadPool(std::size_t threads) : workers_()
+{
+    if (threads == 0)
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    workers_.reserve(threads);
+    for (std::size_t i = 0; i < threads; ++i) {
+        workers_.push_back(std::unique_ptr<Worker>(new Worker()));
+        workers_.back()->thread = std::thread(&KeyedThreadPool::work, this, std::ref(*workers_.back()));
+    }
+}
+
+KeyedThreadPool::~KeyedThreadPool()
+{
+    for (std::unique_ptr<Worker> &worker : workers_) {
+        worker->stopping = true;
+        worker->readable.notify();
+    }
+    for (std::unique_ptr<Worker> &worker : workers_)
+        worker->thread.join();
+}
+
+void KeyedThreadPool::submit(std::size_t key, std::function<void()> task)
+{
+    Worker &worker = *workers_[key % workers_.size()];
+    worker.submitted.fetch_add(1, std::memory_order_relaxed);
+    while (!worker.queue.tryPush(task))
+        worker.writable.wait([&worker]() { return !worker.queue.full(); });
+    worker.readable.notify();
+}
+
+void KeyedThreadPool::submitAfterAll(std::function<void()> task)
+{
+    // Every worker counts down once it reaches this point of its queue; the last one runs task
+    std::shared_ptr<std::atomic<std::size_t>> remaining =
+        std::make_shared<std::atomic<std::size_t>>(workers_.size());
+    std::shared_ptr<std::function<void()>> shared = std::make_shared<std::function<void()>>(std::move(task));
+    for (std::size_t i = 0; i < workers_.size(); ++i) {
+        submit(i, [remaining, shared]() {
+            if (--*remaining == 0)
+                (*shared)();
+        });
+    }
+}
+
+void KeyedThreadPool::wait()
+{
+    for (std::unique_ptr<Worker> &worker : workers_) {
+        std::size_t target = worker->submitted.load(std::memory_order_relaxed);
+        Worker &w = *worker;
+        w.idle.wait([&w, target]() { return w.completed.load(std::memory_order_acquire) >= target; });
+    }
+}
+
+std::size_t KeyedThreadPool::pending() const
+{
+    std::size_t pending = 0;
+    for (const std::unique_ptr<Worker> &worker : workers_) {
+        // completed first: it never passes submitted, so the difference can't wrap
+        std::size_t completed = worker->completed.load(std::memory_order_acquire);
+        pending += worker->submitted.load(std::memory_order_relaxed) - completed;
+    }
+    return pending;
+}
+
+void KeyedThreadPool::work(Worker &worker)
+{
+    std::vector<std::function<void()>> batch;
+    batch.reserve(BATCH);
+    while (true) {
+        worker.readable.wait([&worker]() { return worker.queue.readable() || worker.stopping; });
+        if (worker.queue.popBatch(batch, BATCH) == 0)
+            return; // stopping and nothing left to run
+        worker.writable.notify();
+        for (std::function<void()> &task : batch)
+            task();
+        worker.completed.fetch_add(batch.size(), std::memory_order_release);
+        batch.clear();
+        worker.idle.notify();
+    }
+}
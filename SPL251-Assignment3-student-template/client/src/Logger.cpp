@@ -0,0 +1,228 @@
+#include "../include/Logger.h"
+#include <algorithm>
+#include <cstdio>
+#include <ctime>
+#include <iostream>
+
+static const char *LEVEL_NAMES[] = {"debug", "info", "warn", "error", "off"};
+static const char *CATEGORY_NAMES[] = {"client", "frame", "connection", "protocol"};
+
+static std::atomic<std::uint64_t> nextLoggerId(1);
+
+// The rings a thread logs into, one per logger; marked abandoned when the thread exits
+struct Logger::ThreadRings {
+    std::vector<std::pair<std::uint64_t, std::shared_ptr<Ring>>> rings;
+
+    ThreadRings() : rings() {}
+    ~ThreadRings() {
+        for (std::pair<std::uint64_t, std::shared_ptr<Ring>> &entry : rings)
+            entry.second->abandoned = true;
+    }
+};
+
+Logger::Logger()
+    : id_(nextLoggerId++), levels_(), sinksMutex_(), sinks_(), files_(), ringsMutex_(), rings_(), ringsVersion_(0),
+      nextThread_(1), sequence_(0), written_(0), stopping_(false), pending_(), writable_(), drained_(), writer_()
+{
+    for (std::atomic<int> &level : levels_)
+        level.store(static_cast<int>(LogLevel::Info), std::memory_order_relaxed);
+    writer_ = std::thread(&Logger::writeRecords, this);
+}
+
+Logger::~Logger()
+{
+    stopping_ = true;
+    pending_.notify();
+    writer_.join();
+}
+
+Logger &Logger::console()
+{
+    static Logger logger;
+    static bool configured = (logger.addSink(&std::cout, LogFormat::Plain, LogLevel::Debug, LogLevel::Info),
+                              logger.addSink(&std::cerr, LogFormat::Plain, LogLevel::Warn), true);
+    (void)configured;
+    return logger;
+}
+
+void Logger::addSink(std::ostream *stream, LogFormat format, LogLevel minLevel, LogLevel maxLevel)
+{
+    Sink sink = {stream, format, minLevel, maxLevel};
+    std::lock_guard<std::mutex> lock(sinksMutex_);
+    sinks_.push_back(sink);
+}
+
+bool Logger::addFileSink(const std::string &path, LogFormat format, LogLevel minLevel)
+{
+    std::unique_ptr<std::ofstream> file(new std::ofstream(path.c_str(), std::ios::app));
+    if (!*file)
+        return false;
+    addSink(file.get(), format, minLevel);
+    std::lock_guard<std::mutex> lock(sinksMutex_);
+    files_.push_back(std::move(file));
+    return true;
+}
+
+void Logger::setLevel(LogCategory category, LogLevel level)
+{
+    levels_[static_cast<int>(category)].store(static_cast<int>(level), std::memory_order_relaxed);
+}
+
+void Logger::setLevel(LogLevel level)
+{
+    for (std::atomic<int> &categoryLevel : levels_)
+        categoryLevel.store(static_cast<int>(level), std::memory_order_relaxed);
+}
+
+Logger::Ring &Logger::threadRing()
+{
+    thread_local ThreadRings local;
+    for (std::pair<std::uint64_t, std::shared_ptr<Ring>> &entry : local.rings) {
+        if (entry.first == id_)
+            return *entry.second;
+    }
+    std::shared_ptr<Ring> ring;
+    {
+        std::lock_guard<std::mutex> lock(ringsMutex_);
+        ring = std::make_shared<Ring>(nextThread_++);
+        rings_.push_back(ring);
+        ++ringsVersion_;
+    }
+    local.rings.push_back(std::make_pair(id_, ring));
+    return *ring;
+}
+
+void Logger::log(LogLevel level, LogCategory category, std::string message)
+{
+    if (!enabled(level, category))
+        return;
+    Record record;
+    record.level = level;
+    record.category = category;
+    record.time = std::chrono::system_clock::now();
+    record.message = std::move(message);
+
+    Ring &ring = threadRing();
+    record.sequence = sequence_.fetch_add(1);
+    while (!ring.records.tryPush(record))
+        writable_.wait([&ring]() { return !ring.records.full(); });
+    pending_.notify();
+}
+
+void Logger::flush()
+{
+    std::uint64_t target = sequence_.load();
+    drained_.wait([this, target]() { return written_.load(std::memory_order_acquire) >= target; });
+}
+
+// The writer thread
+void Logger::writeRecords()
+{
+    std::vector<std::shared_ptr<Ring>> rings;
+    std::uint64_t version = ~std::uint64_t(0);
+    std::vector<Record> batch;
+    std::uint64_t written = 0;
+    while (true) {
+        pending_.wait([this, written]() { return sequence_.load() != written || stopping_.load(); });
+        if (ringsVersion_.load() != version) {
+            std::lock_guard<std::mutex> lock(ringsMutex_);
+            rings = rings_;
+            version = ringsVersion_.load();
+        }
+
+        batch.clear();
+        bool drainedAbandoned = false;
+        for (std::shared_ptr<Ring> &ring : rings) {
+            std::size_t first = batch.size();
+            ring->records.popBatch(batch, RING_CAPACITY);
+            for (std::size_t i = first; i < batch.size(); ++i)
+                batch[i].thread = ring->thread;
+            if (ring->abandoned && !ring->records.readable())
+                drainedAbandoned = true;
+        }
+        if (drainedAbandoned) {
+            std::lock_guard<std::mutex> lock(ringsMutex_);
+            rings_.erase(std::remove_if(rings_.begin(), rings_.end(),
+                                        [](const std::shared_ptr<Ring> &ring) {
+                                            return ring->abandoned && !ring->records.readable();
+                                        }),
+                         rings_.end());
+            ++ringsVersion_;
+        }
+        if (batch.empty()) {
+            if (stopping_ && sequence_.load() == written)
+                return;
+            std::this_thread::yield(); // a record was numbered and is still being pushed
+            continue;
+        }
+        writable_.notify();
+
+        std::sort(batch.begin(), batch.end(),
+                  [](const Record &a, const Record &b) { return a.sequence < b.sequence; });
+        {
+            std::lock_guard<std::mutex> lock(sinksMutex_);
+            for (const Record &record : batch) {
+                for (const Sink &sink : sinks_) {
+                    if (record.level >= sink.minLevel && record.level <= sink.maxLevel)
+                        write(record, sink);
+                }
+            }
+            for (const Sink &sink : sinks_)
+                sink.stream->flush();
+        }
+        written += batch.size();
+        written_.store(written, std::memory_order_release);
+        drained_.notify();
+    }
+}
+
+void Logger::write(const Record &record, const Sink &sink) const
+{
+    std::ostream &out = *sink.stream;
+    if (sink.format == LogFormat::Plain) {
+        out << record.message << '\n';
+        return;
+    }
+
+    std::time_t seconds = std::chrono::system_clock::to_time_t(record.time);
+    long long millis = std::chrono::duration_cast<std::chrono::milliseconds>(record.time.time_since_epoch()).count() % 1000;
+    std::tm utc;
+    gmtime_r(&seconds, &utc);
+    char timestamp[64];
+    std::snprintf(timestamp, sizeof(timestamp), "%04d-%02d-%02dT%02d:%02d:%02d.%03lldZ", utc.tm_year + 1900,
+                  utc.tm_mon + 1, utc.tm_mday, utc.tm_hour, utc.tm_min, utc.tm_sec, millis);
+    out << "ts=" << timestamp << " level=" << LEVEL_NAMES[static_cast<int>(record.level)]
+        << " category=" << CATEGORY_NAMES[static_cast<int>(record.category)] << " thread=" << record.thread
+        << " msg=\"";
+    for (char c : record.message) {
+        if (c == '"' || c == '\\')
+            out << '\\' << c;
+        else if (c == '\n')
+            out << "\\n";
+        else if (c != '\0')
+            out << c;
+    }
+    out << "\"\n";
+}
+
+bool Logger::parseLevel(const std::string &name, LogLevel &level)
+{
+    for (int i = 0; i <= static_cast<int>(LogLevel::Off); ++i) {
+        if (name == LEVEL_NAMES[i]) {
+            level = static_cast<LogLevel>(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+bool Logger::parseCategory(const std::string &name, LogCategory &category)
+{
+    for (int i = 0; i < static_cast<int>(LogCategory::Count); ++i) {
+        if (name == CATEGORY_NAMES[i]) {
+            category = static_cast<LogCategory>(i);
+            return true;
+        }
+    }
+    return false;
+}
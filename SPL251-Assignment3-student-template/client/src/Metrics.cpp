@@ -0,0 +1,326 @@
+#include "../include/Metrics.h"
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+static std::atomic<std::uint64_t> nextRegistryId(1);
+
+thread_local MetricsRegistry::ThreadCache MetricsRegistry::threadCache_ = {0, nullptr};
+
+// The shards a thread updates, one per registry; marked abandoned when the thread exits
+struct MetricsRegistry::ThreadShards {
+    std::vector<std::pair<std::uint64_t, std::shared_ptr<Shard>>> shards;
+
+    ThreadShards() : shards() {}
+    ~ThreadShards() {
+        for (std::pair<std::uint64_t, std::shared_ptr<Shard>> &entry : shards)
+            entry.second->abandoned.store(true, std::memory_order_release);
+        threadCache_.registry = 0;
+    }
+};
+
+// "name{labels}", with extra appended to the labels
+static std::string seriesName(const std::string &name, const std::string &labels, const std::string &extra = "")
+{
+    if (labels.empty() && extra.empty())
+        return name;
+    return name + "{" + labels + (labels.empty() || extra.empty() ? "" : ",") + extra + "}";
+}
+
+std::string formatDuration(std::uint64_t nanoseconds)
+{
+    char text[32];
+    if (nanoseconds < 1000)
+        std::snprintf(text, sizeof(text), "%lluns", static_cast<unsigned long long>(nanoseconds));
+    else if (nanoseconds < 1000000)
+        std::snprintf(text, sizeof(text), "%.1fus", nanoseconds / 1e3);
+    else if (nanoseconds < 1000000000)
+        std::snprintf(text, sizeof(text), "%.2fms", nanoseconds / 1e6);
+    else
+        std::snprintf(text, sizeof(text), "%.2fs", nanoseconds / 1e9);
+    return text;
+}
+
+static std::string formatNumber(double value, const char *format = "%.9g")
+{
+    char text[32];
+    std::snprintf(text, sizeof(text), format, value);
+    return text;
+}
+
+MetricsRegistry::MetricsRegistry()
+    : id_(nextRegistryId++), mutex_(), metrics_(), usedSlots_(0), shards_(), retired_(MAX_SLOTS, 0), dumpMutex_(),
+      dumpChanged_(), dumpPath_(), dumpStopping_(false), dumper_() {}
+
+MetricsRegistry::~MetricsRegistry()
+{
+    stopDumping();
+}
+
+MetricsRegistry &MetricsRegistry::global()
+{
+    static MetricsRegistry registry;
+    return registry;
+}
+
+std::atomic<std::uint64_t> *MetricsRegistry::registerThread()
+{
+    thread_local ThreadShards local;
+    std::shared_ptr<Shard> shard;
+    for (std::pair<std::uint64_t, std::shared_ptr<Shard>> &entry : local.shards) {
+        if (entry.first == id_)
+            shard = entry.second;
+    }
+    if (!shard) {
+        shard = std::make_shared<Shard>();
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            shards_.push_back(shard);
+        }
+        local.shards.push_back(std::make_pair(id_, shard));
+    }
+    threadCache_.registry = id_;
+    threadCache_.slots = shard->slots.get();
+    return threadCache_.slots;
+}
+
+std::size_t MetricsRegistry::allocate(const std::string &name, const std::string &help, const std::string &labels,
+                                      Kind kind, std::size_t slots, std::function<double()> read)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const Metric &metric : metrics_) {
+        if (metric.name == name && metric.labels == labels) {
+            if (metric.kind != kind)
+                throw std::invalid_argument("metric registered with another type: " + name);
+            return metric.slot;
+        }
+    }
+    if (usedSlots_ + slots > MAX_SLOTS)
+        throw std::length_error("too many metrics: " + name);
+    Metric metric = {name, labels, help, kind, usedSlots_, std::move(read)};
+    metrics_.push_back(std::move(metric));
+    usedSlots_ += slots;
+    return metrics_.back().slot;
+}
+
+MetricsRegistry::Counter MetricsRegistry::counter(const std::string &name, const std::string &help,
+                                                  const std::string &labels)
+{
+    return Counter(this, allocate(name, help, labels, Kind::Counter, 1, std::function<double()>()));
+}
+
+MetricsRegistry::Histogram MetricsRegistry::histogram(const std::string &name, const std::string &help,
+                                                      const std::string &labels)
+{
+    // The buckets, then the sum
+    return Histogram(this, allocate(name, help, labels, Kind::Histogram, HISTOGRAM_BUCKETS + 1,
+                                    std::function<double()>()));
+}
+
+void MetricsRegistry::gauge(const std::string &name, const std::string &help, std::function<double()> read,
+                            const std::string &labels)
+{
+    allocate(name, help, labels, Kind::Gauge, 0, std::move(read));
+}
+
+std::vector<std::uint64_t> MetricsRegistry::collectLocked() const
+{
+    std::vector<std::uint64_t> totals(retired_.begin(), retired_.begin() + usedSlots_);
+    std::size_t kept = 0;
+    for (std::size_t i = 0; i < shards_.size(); ++i) {
+        const Shard &shard = *shards_[i];
+        // Its thread is gone, so these are the final values
+        bool abandoned = shard.abandoned.load(std::memory_order_acquire);
+        for (std::size_t slot = 0; slot < usedSlots_; ++slot) {
+            std::uint64_t value = shard.slots[slot].load(std::memory_order_relaxed);
+            totals[slot] += value;
+            if (abandoned)
+                retired_[slot] += value;
+        }
+        if (!abandoned)
+            shards_[kept++] = shards_[i];
+    }
+    shards_.resize(kept);
+    return totals;
+}
+
+MetricsRegistry::HistogramSnapshot MetricsRegistry::snapshotLocked(const std::vector<std::uint64_t> &totals,
+                                                                   std::size_t slot) const
+{
+    HistogramSnapshot snapshot;
+    snapshot.buckets.assign(totals.begin() + slot, totals.begin() + slot + HISTOGRAM_BUCKETS);
+    for (std::uint64_t count : snapshot.buckets)
+        snapshot.count += count;
+    snapshot.sumNanoseconds = totals[slot + HISTOGRAM_BUCKETS];
+    return snapshot;
+}
+
+std::uint64_t MetricsRegistry::value(const Counter &counter) const
+{
+    if (counter.registry_ != this)
+        return 0;
+    std::lock_guard<std::mutex> lock(mutex_);
+    return collectLocked()[counter.slot_];
+}
+
+MetricsRegistry::HistogramSnapshot MetricsRegistry::snapshot(const Histogram &histogram) const
+{
+    if (histogram.registry_ != this)
+        return HistogramSnapshot();
+    std::lock_guard<std::mutex> lock(mutex_);
+    return snapshotLocked(collectLocked(), histogram.slot_);
+}
+
+std::uint64_t MetricsRegistry::bucketValue(std::size_t index)
+{
+    const std::size_t subBuckets = std::size_t(1) << SUB_BUCKET_BITS;
+    if (index < subBuckets)
+        return index;
+    std::size_t shift = index / subBuckets - 1;
+    std::uint64_t lower = std::uint64_t(subBuckets + index % subBuckets) << shift;
+    return lower + (std::uint64_t(1) << shift) / 2;
+}
+
+void MetricsRegistry::HistogramSnapshot::add(std::uint64_t nanoseconds)
+{
+    if (buckets.empty())
+        buckets.assign(HISTOGRAM_BUCKETS, 0);
+    ++buckets[bucketIndex(nanoseconds)];
+    ++count;
+    sumNanoseconds += nanoseconds;
+}
+
+std::uint64_t MetricsRegistry::HistogramSnapshot::percentile(double q) const
+{
+    if (count == 0)
+        return 0;
+    std::uint64_t rank = static_cast<std::uint64_t>(std::ceil(q * count));
+    if (rank == 0)
+        rank = 1;
+    std::uint64_t seen = 0;
+    for (std::size_t i = 0; i < buckets.size(); ++i) {
+        seen += buckets[i];
+        if (seen >= rank)
+            return bucketValue(i);
+    }
+    return bucketValue(buckets.size() - 1);
+}
+
+void MetricsRegistry::render(std::ostream &out) const
+{
+    // Gauges run outside the lock: they may update metrics themselves
+    std::vector<Metric> metrics;
+    std::vector<std::uint64_t> totals;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        metrics = metrics_;
+        totals = collectLocked();
+    }
+    for (const Metric &metric : metrics) {
+        out << seriesName(metric.name, metric.labels) << "  ";
+        if (metric.kind == Kind::Counter) {
+            out << totals[metric.slot];
+        } else if (metric.kind == Kind::Gauge) {
+            out << formatNumber(metric.read(), "%g");
+        } else {
+            HistogramSnapshot snapshot = snapshotLocked(totals, metric.slot);
+            out << "count " << snapshot.count;
+            if (snapshot.count > 0) {
+                out << "  p50 " << formatDuration(snapshot.percentile(0.5)) << "  p99 "
+                    << formatDuration(snapshot.percentile(0.99)) << "  p99.9 "
+                    << formatDuration(snapshot.percentile(0.999)) << "  max " << formatDuration(snapshot.max());
+            }
+        }
+        out << "\n";
+    }
+}
+
+void MetricsRegistry::renderPrometheus(std::ostream &out) const
+{
+    std::vector<Metric> metrics;
+    std::vector<std::uint64_t> totals;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        metrics = metrics_;
+        totals = collectLocked();
+    }
+    static const char *TYPE_NAMES[] = {"counter", "summary", "gauge"};
+    static const double QUANTILES[] = {0.5, 0.9, 0.99, 0.999};
+    // Every series of a name follows its HELP and TYPE lines
+    std::vector<bool> written(metrics.size(), false);
+    for (std::size_t first = 0; first < metrics.size(); ++first) {
+        if (written[first])
+            continue;
+        const Metric &family = metrics[first];
+        out << "# HELP " << family.name << " " << family.help << "\n"
+            << "# TYPE " << family.name << " " << TYPE_NAMES[static_cast<int>(family.kind)] << "\n";
+        for (std::size_t i = first; i < metrics.size(); ++i) {
+            const Metric &metric = metrics[i];
+            if (written[i] || metric.name != family.name)
+                continue;
+            written[i] = true;
+            if (metric.kind == Kind::Counter) {
+                out << seriesName(metric.name, metric.labels) << " " << totals[metric.slot] << "\n";
+            } else if (metric.kind == Kind::Gauge) {
+                out << seriesName(metric.name, metric.labels) << " " << formatNumber(metric.read()) << "\n";
+            } else {
+                HistogramSnapshot snapshot = snapshotLocked(totals, metric.slot);
+                for (double q : QUANTILES) {
+                    out << seriesName(metric.name, metric.labels, "quantile=\"" + formatNumber(q, "%g") + "\"") << " "
+                        << formatNumber(snapshot.percentile(q) / 1e9) << "\n";
+                }
+                out << seriesName(metric.name + "_sum", metric.labels) << " "
+                    << formatNumber(snapshot.sumNanoseconds / 1e9) << "\n"
+                    << seriesName(metric.name + "_count", metric.labels) << " " << snapshot.count << "\n";
+            }
+        }
+    }
+}
+
+bool MetricsRegistry::writePrometheus(const std::string &path) const
+{
+    std::ostringstream text;
+    renderPrometheus(text);
+    std::string temporary = path + ".tmp";
+    {
+        std::ofstream file(temporary.c_str(), std::ios::trunc);
+        if (!(file << text.str()) || !file.flush())
+            return false;
+    }
+    return std::rename(temporary.c_str(), path.c_str()) == 0;
+}
+
+bool MetricsRegistry::dumpEvery(const std::string &path, int intervalSeconds)
+{
+    stopDumping();
+    if (!writePrometheus(path))
+        return false;
+    std::lock_guard<std::mutex> lock(dumpMutex_);
+    dumpPath_ = path;
+    dumpStopping_ = false;
+    dumper_ = std::thread(&MetricsRegistry::dump, this, intervalSeconds > 0 ? intervalSeconds : 1);
+    return true;
+}
+
+void MetricsRegistry::stopDumping()
+{
+    {
+        std::lock_guard<std::mutex> lock(dumpMutex_);
+        if (!dumper_.joinable())
+            return;
+        dumpStopping_ = true;
+    }
+    dumpChanged_.notify_all();
+    dumper_.join();
+    writePrometheus(dumpPath_);
+}
+
+// The dump thread
+void MetricsRegistry::dump(int intervalSeconds)
+{
+    std::unique_lock<std::mutex> lock(dumpMutex_);
+    while (!dumpChanged_.wait_for(lock, std::chrono::seconds(intervalSeconds), [this]() { return dumpStopping_; }))
+        writePrometheus(dumpPath_);
+}
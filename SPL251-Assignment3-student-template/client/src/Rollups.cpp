@@ -0,0 +1,263 @@
+#include "../include/Rollups.h"
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+
+static const char *const FILE_HEADER = "stomp-rollups 1";
+
+static bool isFlagSet(const Event &event, const std::string &flag)
+{
+    const std::map<std::string, std::string> &info = event.get_general_information();
+    std::map<std::string, std::string>::const_iterator it = info.find(flag);
+    return it != info.end() && it->second == "true";
+}
+
+// Start of the bucket holding time; floors toward minus infinity so pre-1970 times still align. The
+// first bucket would start before INT_MIN and is clamped to it.
+static int bucketStart(long long time, int width)
+{
+    long long start = time / width * width;
+    if (start > time)
+        start -= width;
+    return static_cast<int>(std::max(start, static_cast<long long>(INT_MIN)));
+}
+
+static void addCounts(SummaryCounts &into, const SummaryCounts &counts)
+{
+    into.total += counts.total;
+    into.active += counts.active;
+    into.forcesArrivalAtScene += counts.forcesArrivalAtScene;
+}
+
+// Tabs, newlines and backslashes are escaped so every field stays on its line
+static std::string escapeField(const std::string &value)
+{
+    std::string escaped;
+    escaped.reserve(value.size());
+    for (char c : value) {
+        if (c == '\\')
+            escaped += "\\\\";
+        else if (c == '\t')
+            escaped += "\\t";
+        else if (c == '\n')
+            escaped += "\\n";
+        else
+            escaped += c;
+    }
+    return escaped;
+}
+
+static bool unescapeField(const std::string &value, std::string &field)
+{
+    field.clear();
+    for (std::size_t i = 0; i < value.size(); ++i) {
+        if (value[i] != '\\') {
+            field += value[i];
+            continue;
+        }
+        if (++i == value.size())
+            return false;
+        if (value[i] == '\\')
+            field += '\\';
+        else if (value[i] == 't')
+            field += '\t';
+        else if (value[i] == 'n')
+            field += '\n';
+        else
+            return false;
+    }
+    return true;
+}
+
+static bool parseNumber(const std::string &text, long long &number)
+{
+    if (text.empty())
+        return false;
+    char *end = nullptr;
+    errno = 0;
+    number = std::strtoll(text.c_str(), &end, 10);
+    return errno == 0 && *end == '\0';
+}
+
+RollupTable::RollupTable() : mutex_(), cities_(), channels_() {}
+
+int RollupTable::bucketSeconds(RollupResolution resolution)
+{
+    return resolution == RollupResolution::Hour ? HOUR_SECONDS : DAY_SECONDS;
+}
+
+void RollupTable::addLocked(const std::string &channel, const std::string &city, RollupResolution resolution,
+                            int start, const SummaryCounts &counts)
+{
+    addCounts(cities_[channel][city].at(resolution)[start], counts);
+    addCounts(channels_[channel].at(resolution)[start], counts);
+}
+
+void RollupTable::add(const Event &event)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    addLocked(event);
+}
+
+void RollupTable::add(const std::vector<Event> &events)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const Event &event : events)
+        addLocked(event);
+}
+
+void RollupTable::addLocked(const Event &event)
+{
+    SummaryCounts counts;
+    counts.total = 1;
+    counts.active = isFlagSet(event, "active") ? 1 : 0;
+    counts.forcesArrivalAtScene = isFlagSet(event, "forces_arrival_at_scene") ? 1 : 0;
+    long long time = event.get_date_time();
+    addLocked(event.get_channel_name(), event.get_city(), RollupResolution::Hour, bucketStart(time, HOUR_SECONDS),
+              counts);
+    addLocked(event.get_channel_name(), event.get_city(), RollupResolution::Day, bucketStart(time, DAY_SECONDS),
+              counts);
+}
+
+std::vector<RollupTable::Row> RollupTable::query(const std::string &channel, const std::string &city,
+                                                 RollupResolution resolution, int from, int to) const
+{
+    std::vector<Row> rows;
+    std::lock_guard<std::mutex> lock(mutex_);
+    const Series *series = nullptr;
+    if (city.empty()) {
+        auto it = channels_.find(channel);
+        if (it != channels_.end())
+            series = &it->second;
+    } else {
+        auto channelIt = cities_.find(channel);
+        if (channelIt != cities_.end()) {
+            auto it = channelIt->second.find(city);
+            if (it != channelIt->second.end())
+                series = &it->second;
+        }
+    }
+    if (series == nullptr || from > to)
+        return rows;
+
+    const Buckets &buckets = series->at(resolution);
+    Buckets::const_iterator end = buckets.upper_bound(to);
+    for (Buckets::const_iterator it = buckets.lower_bound(bucketStart(from, bucketSeconds(resolution))); it != end;
+         ++it) {
+        rows.push_back(Row());
+        rows.back().start = it->first;
+        rows.back().counts = it->second;
+    }
+    return rows;
+}
+
+void RollupTable::clear()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    cities_.clear();
+    channels_.clear();
+}
+
+std::size_t RollupTable::bucketCount() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::size_t count = 0;
+    for (const auto &channel : cities_) {
+        for (const auto &city : channel.second)
+            count += city.second.hours.size() + city.second.days.size();
+    }
+    return count;
+}
+
+// One line per (resolution, channel, city, bucket); the per-channel totals are rebuilt on load
+bool RollupTable::save(const std::string &path) const
+{
+    std::string temporary = path + ".tmp";
+    std::FILE *file = std::fopen(temporary.c_str(), "wb");
+    if (file == nullptr)
+        return false;
+    bool ok = std::fprintf(file, "%s\n", FILE_HEADER) > 0;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (const auto &channel : cities_) {
+            std::string channelField = escapeField(channel.first);
+            for (const auto &city : channel.second) {
+                std::string cityField = escapeField(city.first);
+                for (RollupResolution resolution : {RollupResolution::Hour, RollupResolution::Day}) {
+                    for (const auto &bucket : city.second.at(resolution)) {
+                        ok = ok && std::fprintf(file, "%c\t%s\t%s\t%d\t%zu\t%zu\t%zu\n",
+                                                resolution == RollupResolution::Hour ? 'h' : 'd',
+                                                channelField.c_str(), cityField.c_str(), bucket.first,
+                                                bucket.second.total, bucket.second.active,
+                                                bucket.second.forcesArrivalAtScene) > 0;
+                    }
+                }
+            }
+        }
+    }
+    ok = std::fclose(file) == 0 && ok;
+    if (!ok || std::rename(temporary.c_str(), path.c_str()) != 0) {
+        std::remove(temporary.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool RollupTable::load(const std::string &path)
+{
+    std::ifstream in(path.c_str());
+    if (!in)
+        return errno == ENOENT; // nothing saved yet
+    std::string line;
+    if (!std::getline(in, line) || line != FILE_HEADER)
+        return false;
+
+    // Parse everything first so a damaged file adds nothing
+    struct Entry {
+        RollupResolution resolution;
+        std::string channel;
+        std::string city;
+        int start;
+        SummaryCounts counts;
+
+        Entry() : resolution(RollupResolution::Hour), channel(), city(), start(0), counts() {}
+    };
+    std::vector<Entry> entries;
+    while (std::getline(in, line)) {
+        std::vector<std::string> fields(1);
+        for (char c : line) {
+            if (c == '\t')
+                fields.push_back(std::string());
+            else
+                fields.back() += c;
+        }
+        Entry entry;
+        long long numbers[4];
+        if (fields.size() != 7 || (fields[0] != "h" && fields[0] != "d") ||
+            !unescapeField(fields[1], entry.channel) || !unescapeField(fields[2], entry.city))
+            return false;
+        for (int i = 0; i < 4; ++i) {
+            if (!parseNumber(fields[3 + i], numbers[i]) || (i > 0 && numbers[i] < 0))
+                return false;
+        }
+        entry.resolution = fields[0] == "h" ? RollupResolution::Hour : RollupResolution::Day;
+        if (numbers[0] < INT_MIN || numbers[0] > INT_MAX ||
+            numbers[0] != bucketStart(numbers[0], bucketSeconds(entry.resolution)))
+            return false;
+        entry.start = static_cast<int>(numbers[0]);
+        entry.counts.total = static_cast<std::size_t>(numbers[1]);
+        entry.counts.active = static_cast<std::size_t>(numbers[2]);
+        entry.counts.forcesArrivalAtScene = static_cast<std::size_t>(numbers[3]);
+        entries.push_back(entry);
+    }
+    if (in.bad())
+        return false;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const Entry &entry : entries)
+        addLocked(entry.channel, entry.city, entry.resolution, entry.start, entry.counts);
+    return true;
+}
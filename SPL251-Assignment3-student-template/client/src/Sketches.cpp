@@ -0,0 +1,173 @@
+#include "../include/Sketches.h"
+#include "../include/Hash.h"
+#include <cmath>
+
+SpaceSaving::SpaceSaving(std::size_t capacity) : capacity_(capacity), entries_(), slots_(), heap_(), heapPosition_()
+{
+    entries_.reserve(capacity);
+    heap_.reserve(capacity);
+    heapPosition_.reserve(capacity);
+}
+
+void SpaceSaving::swapHeap(std::size_t a, std::size_t b)
+{
+    std::swap(heap_[a], heap_[b]);
+    heapPosition_[heap_[a]] = a;
+    heapPosition_[heap_[b]] = b;
+}
+
+void SpaceSaving::siftDown(std::size_t position)
+{
+    std::size_t size = heap_.size();
+    while (true) {
+        std::size_t smallest = position;
+        std::size_t left = 2 * position + 1, right = left + 1;
+        if (left < size && entries_[heap_[left]].count < entries_[heap_[smallest]].count)
+            smallest = left;
+        if (right < size && entries_[heap_[right]].count < entries_[heap_[smallest]].count)
+            smallest = right;
+        if (smallest == position)
+            return;
+        swapHeap(position, smallest);
+        position = smallest;
+    }
+}
+
+void SpaceSaving::siftUp(std::size_t position)
+{
+    while (position > 0) {
+        std::size_t parent = (position - 1) / 2;
+        if (entries_[heap_[parent]].count <= entries_[heap_[position]].count)
+            return;
+        swapHeap(position, parent);
+        position = parent;
+    }
+}
+
+void SpaceSaving::add(const std::string &key, std::uint64_t weight)
+{
+    std::unordered_map<std::string, std::size_t>::iterator slot = slots_.find(key);
+    if (slot != slots_.end()) {
+        entries_[slot->second].count += weight;
+        siftDown(heapPosition_[slot->second]);
+        return;
+    }
+    if (entries_.size() < capacity_) {
+        std::size_t index = entries_.size();
+        Entry entry = {key, weight, 0};
+        entries_.push_back(entry);
+        slots_[key] = index;
+        heap_.push_back(index);
+        heapPosition_.push_back(heap_.size() - 1);
+        siftUp(heap_.size() - 1);
+        return;
+    }
+    if (capacity_ == 0)
+        return;
+
+    // Evict the smallest counter; the newcomer inherits its count as error
+    std::size_t index = heap_[0];
+    Entry &entry = entries_[index];
+    slots_.erase(entry.key);
+    entry.key = key;
+    entry.error = entry.count;
+    entry.count += weight;
+    slots_[key] = index;
+    siftDown(0);
+}
+
+void SpaceSaving::clear()
+{
+    entries_.clear();
+    slots_.clear();
+    heap_.clear();
+    heapPosition_.clear();
+}
+
+std::vector<SpaceSaving::Entry> SpaceSaving::top(std::size_t k) const
+{
+    std::vector<Entry> result(entries_);
+    std::size_t n = std::min(k, result.size());
+    std::partial_sort(result.begin(), result.begin() + n, result.end(), [](const Entry &a, const Entry &b) {
+        return a.count != b.count ? a.count > b.count : a.key < b.key;
+    });
+    result.erase(result.begin() + n, result.end());
+    return result;
+}
+
+static std::size_t roundUpToPowerOfTwo(std::size_t value)
+{
+    std::size_t power = 64;
+    while (power < value)
+        power <<= 1;
+    return power;
+}
+
+BloomFilter::BloomFilter(std::size_t bits, int hashes)
+    : words_(roundUpToPowerOfTwo(bits) / 64, 0), bitMask_(roundUpToPowerOfTwo(bits) - 1), hashes_(hashes) {}
+
+void BloomFilter::add(std::uint64_t hash)
+{
+    std::uint64_t step = mix64(hash) | 1; // odd, so probes differ for every power-of-two size
+    for (int i = 0; i < hashes_; ++i, hash += step) {
+        std::uint64_t bit = hash & bitMask_;
+        words_[bit >> 6] |= std::uint64_t(1) << (bit & 63);
+    }
+}
+
+bool BloomFilter::mightContain(std::uint64_t hash) const
+{
+    std::uint64_t step = mix64(hash) | 1;
+    for (int i = 0; i < hashes_; ++i, hash += step) {
+        std::uint64_t bit = hash & bitMask_;
+        if ((words_[bit >> 6] & (std::uint64_t(1) << (bit & 63))) == 0)
+            return false;
+    }
+    return true;
+}
+
+void BloomFilter::clear()
+{
+    std::fill(words_.begin(), words_.end(), 0);
+}
+
+HyperLogLog::HyperLogLog() : registers_(std::size_t(1) << PRECISION, 0) {}
+
+void HyperLogLog::add(const std::string &key)
+{
+    addHash(hash64(key));
+}
+
+void HyperLogLog::addHash(std::uint64_t hash)
+{
+    std::size_t index = static_cast<std::size_t>(hash >> (64 - PRECISION));
+    std::uint64_t rest = (hash << PRECISION) | (std::uint64_t(1) << (PRECISION - 1)); // bound the rank
+    std::uint8_t rank = 1;
+    while ((rest & (std::uint64_t(1) << 63)) == 0) {
+        ++rank;
+        rest <<= 1;
+    }
+    if (rank > registers_[index])
+        registers_[index] = rank;
+}
+
+void HyperLogLog::clear()
+{
+    std::fill(registers_.begin(), registers_.end(), 0);
+}
+
+double HyperLogLog::estimate() const
+{
+    const double m = static_cast<double>(registers_.size());
+    double sum = 0;
+    std::size_t zeros = 0;
+    for (std::uint8_t value : registers_) {
+        sum += std::ldexp(1.0, -value);
+        if (value == 0)
+            ++zeros;
+    }
+    double estimate = (0.7213 / (1.0 + 1.079 / m)) * m * m / sum;
+    if (estimate <= 2.5 * m && zeros != 0)
+        return m * std::log(m / zeros); // linear counting is more accurate for small cardinalities
+    return estimate;
+}
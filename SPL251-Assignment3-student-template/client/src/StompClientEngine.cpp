@@ -0,0 +1,782 @@
+#include "../include/StompClientEngine.h"
+#include "../include/SummaryExport.h"
+#include "../include/SummaryQuery.h"
+#include "../include/event.h"
+#include <chrono>
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <sstream>
+
+// How long logout waits for the receipt of its DISCONNECT before closing the connection anyway
+static const int DISCONNECT_TIMEOUT_MS = 2000;
+// How long a script waits for the server to accept its login, and for receipts before a query
+static const int SCRIPT_LOGIN_TIMEOUT_MS = 10000;
+static const int SCRIPT_RECEIPT_TIMEOUT_MS = 60000;
+
+// Where a user's rollups are kept between sessions, in the working directory
+static std::string rollupFileName(const std::string &username)
+{
+    return username + ".rollups";
+}
+
+StompClientOptions::StompClientOptions()
+    : out(&std::cout), err(&std::cerr), store(), callbacks(), messageWorkers(0), stampReports(true) {}
+
+// The body of a SEND frame carrying event
+static std::string serializeEvent(const Event &event)
+{
+    std::ostringstream oss;
+    oss << "event name: " << event.get_name() << "\n"
+        << "description: " << event.get_description() << "\n"
+        << "city: " << event.get_city() << "\n"
+        << "date time: " << event.get_date_time() << "\n"
+        << "general information:\n";
+    for (const auto &pair : event.get_general_information())
+        oss << "  " << pair.first << ": " << pair.second << "\n";
+    return oss.str();
+}
+
+static void appendCounts(std::ostringstream &out, int start, const SummaryCounts &counts)
+{
+    out << epochToDate(start) << "  total: " << counts.total << "  active: " << counts.active
+        << "  forces_arrival_at_scene: " << counts.forcesArrivalAtScene << "\n";
+}
+
+StompClientEngine::StompClientEngine(const StompClientOptions &options)
+    : logger_(), metrics_(),
+      decodeTime_(metrics_.histogram("stomp_message_decode_seconds", "Decoding the event of one MESSAGE frame.")),
+      insertTime_(metrics_.histogram("stomp_store_insert_seconds",
+                                     "Recording one batch of new events: statistics, rollups and the store.")),
+      eventsStored_(metrics_.counter("stomp_events_stored_total", "Events received and stored.")),
+      duplicateEvents_(metrics_.counter("stomp_duplicate_events_total", "Events received again and dropped.")),
+      callbacks_(options.callbacks), terminate_(false), loggedIn_(false), session_(), sessionMutex_(),
+      sessionChanged_(), nextSubscriptionId_(1), eventStore_(options.store), summaryCache_(), streamStats_(),
+      rollups_(), deduplicator_(), deliveryLatency_(metrics_), stampReports_(options.stampReports),
+      messageWorkers_(options.messageWorkers)
+{
+    if (options.out != nullptr)
+        logger_.addSink(options.out, LogFormat::Plain, LogLevel::Debug, LogLevel::Info);
+    if (options.err != nullptr)
+        logger_.addSink(options.err, LogFormat::Plain, LogLevel::Warn);
+    // What no sink shows is not even formatted
+    if (options.out == nullptr)
+        logger_.setLevel(options.err == nullptr ? LogLevel::Off : LogLevel::Warn);
+
+    metrics_.gauge("stomp_message_queue_depth", "Tasks queued or running on the message workers (MESSAGE batches and receipts).",
+                   [this]() { return static_cast<double>(messageWorkers_.pending()); });
+    metrics_.gauge("stomp_store_events", "Events in the store.",
+                   [this]() { return static_cast<double>(eventStore_.snapshot().size()); });
+}
+
+StompClientEngine::~StompClientEngine()
+{
+    endSession();
+    metrics_.stopDumping(); // its gauges read the members destroyed next
+}
+
+void StompClientEngine::logFrame(LogLevel level, const char *prefix, const std::string &frame)
+{
+    if (logger_.enabled(level, LogCategory::Frame))
+        logger_.log(level, LogCategory::Frame, prefix + frame);
+}
+
+void StompClientEngine::execute(const std::string &line)
+{
+    if (line.rfind("login ", 0) == 0)
+        login(line);
+    else if (line.rfind("join ", 0) == 0)
+        join(line);
+    else if (line.rfind("exit ", 0) == 0)
+        exitChannel(line);
+    else if (line.rfind("report ", 0) == 0)
+        report(line);
+    else if (line.rfind("summary ", 0) == 0)
+        summary(line);
+    else if (line.rfind("summary-all ", 0) == 0)
+        summaryAll(line);
+    else if (line.rfind("histogram ", 0) == 0)
+        histogram(line);
+    else if (line.rfind("rollup ", 0) == 0)
+        rollup(line);
+    else if (line.rfind("search ", 0) == 0)
+        search(line);
+    else if (line == "stats" || line.rfind("stats ", 0) == 0)
+        stats(line);
+    else if (line == "latency" || line.rfind("latency ", 0) == 0)
+        latency(line);
+    else if (line == "logout")
+        logout();
+    else if (line == "exit")
+        quit();
+}
+
+void StompClientEngine::run(const StompScript &script)
+{
+    bool loginPending = false;
+    for (const StompScript::Command &command : script.commands()) {
+        if (terminate_)
+            break;
+        // Session commands are queued during the login; only queries need it to be complete
+        if (loginPending && command.kind == StompScript::Kind::Query) {
+            loginPending = false;
+            if (!awaitConnected(SCRIPT_LOGIN_TIMEOUT_MS) && session_)
+                warn("The server did not accept the login.");
+        }
+
+        switch (command.kind) {
+        case StompScript::Kind::Login:
+            execute(command.line);
+            loginPending = !loggedIn_;
+            break;
+        case StompScript::Kind::Report:
+            if (!canSend())
+                warn("You must be logged in to send a report.");
+            else if (!publish(command.report->channel_name, command.report->events, command.receipt))
+                warn("Failed to send report to server.");
+            break;
+        case StompScript::Kind::Query:
+            if (loggedIn_ && !awaitReceipts(SCRIPT_RECEIPT_TIMEOUT_MS) && loggedIn_)
+                warn("Timed out waiting for the server's receipts.");
+            execute(command.line);
+            break;
+        default:
+            execute(command.line);
+            break;
+        }
+    }
+}
+
+// Reader thread: runs until the connection closes
+void StompClientEngine::readFrames(Session *session)
+{
+    std::vector<std::string> frames;
+    while (true) {
+        frames.clear();
+        if (!session->connection->getFrames(frames)) {
+            endHandshake(*session, false);
+            loggedIn_ = false;
+            if (!session->closing)
+                warn("Connection to server lost.");
+            break;
+        }
+        try {
+            handleFrames(*session, frames);
+        } catch (const std::exception &ex) {
+            warn(std::string("Exception in server communication thread: ") + ex.what());
+            terminate_ = true;
+            break;
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(sessionMutex_);
+        session->ended = true;
+    }
+    sessionChanged_.notify_all();
+    if (callbacks_.disconnected)
+        callbacks_.disconnected();
+    say("Server communication thread terminated.");
+}
+
+void StompClientEngine::handleFrames(Session &session, std::vector<std::string> &frames)
+{
+    // MESSAGEs go to the workers one batch per channel. Any other frame is handled after the batches
+    // before it are submitted, so it keeps its place (a RECEIPT after the MESSAGEs it covers).
+    typedef std::pair<std::string, std::shared_ptr<std::vector<std::string>>> ChannelBatch;
+    std::vector<ChannelBatch> batches;
+    std::int64_t receivedAt = DeliveryLatency::now(); // the frames of one read arrived together
+    auto submitBatches = [this, &batches]() {
+        for (ChannelBatch &batch : batches) {
+            std::shared_ptr<std::vector<std::string>> messages = batch.second;
+            // Everything else happens on the channel's worker, so a slow sink never holds up the socket
+            messageWorkers_.submit(std::hash<std::string>()(batch.first),
+                                   [this, messages]() { handleMessages(*messages); });
+        }
+        batches.clear();
+    };
+
+    for (std::string &frame : frames) {
+        if (frame.compare(0, 7, "MESSAGE") != 0) {
+            submitBatches();
+            handleFrame(session, frame);
+            continue;
+        }
+        std::string channel = headerValue(frame, "destination");
+        deliveryLatency_.add(channel, headerValue(frame, "sent-at"), headerValue(frame, "sequence"), receivedAt);
+        std::vector<ChannelBatch>::iterator batch = batches.begin();
+        while (batch != batches.end() && batch->first != channel)
+            ++batch;
+        if (batch == batches.end()) {
+            batches.push_back(ChannelBatch(channel, std::make_shared<std::vector<std::string>>()));
+            batch = batches.end() - 1;
+        }
+        batch->second->push_back(std::move(frame));
+    }
+    submitBatches();
+}
+
+void StompClientEngine::handleFrame(Session &session, const std::string &frame)
+{
+    if (frame.find("CONNECTED") == 0) {
+        say("Login successful.");
+        endHandshake(session, true);
+        sessionChanged_.notify_all();
+        if (callbacks_.connected)
+            callbacks_.connected();
+    } else if (frame.find("ERROR") == 0) {
+        logFrame(LogLevel::Warn, "Server ERROR: ", frame);
+        endHandshake(session, false);
+        if (callbacks_.error)
+            callbacks_.error(frame);
+    } else if (frame.find("RECEIPT") == 0) {
+        logFrame(LogLevel::Info, "Server RECEIPT: ", frame);
+        std::size_t idPos = frame.find("receipt-id:");
+        if (idPos != std::string::npos) {
+            int receipt = std::atoi(frame.c_str() + idPos + 11);
+            session.protocol->receiptReceived(receipt);
+            // Recorded once the MESSAGEs read before it are stored, which is what awaitReceipts promises
+            Session *receiptSession = &session;
+            messageWorkers_.submitAfterAll([this, receiptSession, receipt]() {
+                {
+                    std::lock_guard<std::mutex> lock(sessionMutex_);
+                    if (receipt > receiptSession->receivedReceipt)
+                        receiptSession->receivedReceipt = receipt;
+                }
+                sessionChanged_.notify_all();
+            });
+        }
+    } else {
+        session.protocol->processServerMessage(frame);
+    }
+}
+
+void StompClientEngine::handleMessages(const std::vector<std::string> &frames)
+{
+    // One record for the batch; nothing is built when frames are not logged
+    if (logger_.enabled(LogLevel::Info, LogCategory::Frame)) {
+        std::string printed;
+        for (const std::string &frame : frames)
+            printed.append(printed.empty() ? "" : "\n").append("Server MESSAGE: ").append(frame);
+        logger_.log(LogLevel::Info, LogCategory::Frame, std::move(printed));
+    }
+    try {
+        std::vector<Event> events;
+        std::vector<std::uint64_t> hashes;
+        events.reserve(frames.size());
+        hashes.reserve(frames.size());
+        for (const std::string &frame : frames) {
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            events.push_back(Event(frame.substr(frame.find("\n\n") + 2)));
+            hashes.push_back(events.back().get_content_hash());
+            decodeTime_.record(elapsedNanoseconds(start));
+        }
+        // A report received again (resent file, redelivery after a reconnect) is not counted twice
+        std::vector<bool> fresh;
+        deduplicator_.firstSeen(hashes, fresh);
+        std::size_t kept = 0;
+        for (std::size_t i = 0; i < events.size(); ++i) {
+            if (fresh[i]) {
+                if (kept != i)
+                    events[kept] = events[i];
+                ++kept;
+            }
+        }
+        events.erase(events.begin() + kept, events.end());
+        duplicateEvents_.add(frames.size() - kept);
+        if (events.empty())
+            return;
+
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        streamStats_.add(events);
+        rollups_.add(events);
+        eventStore_.insert(events);
+        insertTime_.record(elapsedNanoseconds(start));
+        eventsStored_.add(events.size());
+        if (callbacks_.event) {
+            for (const Event &e : events)
+                callbacks_.event(e);
+        }
+    } catch (const std::exception &ex) {
+        warn(std::string("Exception in server communication thread: ") + ex.what());
+        terminate_ = true;
+    }
+}
+
+void StompClientEngine::endSession()
+{
+    if (!session_)
+        return;
+    // Unblocks the reader's pending read; the socket itself is closed once the reader is gone
+    session_->closing = true;
+    session_->connection->shutdown();
+    if (session_->reader.joinable())
+        session_->reader.join();
+    // The messages already handed off still belong to this session (and its receipts refer to it)
+    messageWorkers_.wait();
+    session_.reset();
+    loggedIn_ = false;
+}
+
+void StompClientEngine::endHandshake(Session &session, bool accepted)
+{
+    std::lock_guard<std::mutex> sendLock(session.sendMutex);
+    if (!session.handshaking)
+        return;
+    session.handshaking = false;
+    if (accepted) {
+        {
+            std::lock_guard<std::mutex> lock(sessionMutex_);
+            loggedIn_ = true;
+        }
+        // Still under sendMutex, so the command thread's next frames go out after these
+        if (!session.queued.empty() && !session.connection->sendBytes(session.queued.data(), session.queued.size()))
+            warn("Failed to send the commands issued during login.");
+    } else if (session.queuedCommands > 0) {
+        warn("Login failed; " + std::to_string(session.queuedCommands) +
+             " command(s) issued during login were not sent.");
+    }
+    session.queued.clear();
+    session.queuedCommands = 0;
+}
+
+bool StompClientEngine::sendFrames(const std::string &frames)
+{
+    Session &session = *session_;
+    std::lock_guard<std::mutex> sendLock(session.sendMutex);
+    if (session.handshaking) {
+        session.queued += frames;
+        ++session.queuedCommands;
+        return true;
+    }
+    if (!loggedIn_)
+        return false; // the login failed meanwhile
+    return session.connection->sendBytes(frames.data(), frames.size());
+}
+
+bool StompClientEngine::connect(const std::string &host, int port, const std::string &username,
+                                const std::string &password)
+{
+    if (canSend())
+        return false;
+    endSession(); // an earlier login the server refused, or a lost connection
+
+    std::unique_ptr<Session> session(new Session());
+    session->connection.reset(new ConnectionHandler(host, port, logger_, metrics_)); //For establish TCP Connection
+    if (!session->connection->connect())
+        return false;
+    session->protocol.reset(new StompProtocol(*session->connection, logger_, metrics_));
+    session->protocol->setStamping(stampReports_);
+    std::string connectFrame = session->protocol->createConnectFrame(host, username, password);
+    if (!session->connection->sendLine(connectFrame))
+        return false;
+    session->username = username;
+    session->handshaking = true;
+
+    // Start over from what this user's earlier sessions saved
+    rollups_.clear();
+    if (!rollups_.load(rollupFileName(username)))
+        warn("Could not read saved rollups: " + rollupFileName(username));
+
+    session_ = std::move(session);
+    session_->reader = std::thread(&StompClientEngine::readFrames, this, session_.get());
+    return true;
+}
+
+bool StompClientEngine::awaitConnected(int timeoutMs)
+{
+    if (!session_)
+        return false;
+    std::unique_lock<std::mutex> lock(sessionMutex_);
+    Session &session = *session_;
+    return sessionChanged_.wait_for(lock, std::chrono::milliseconds(timeoutMs),
+                                    [this, &session]() { return loggedIn_ || session.ended; }) && loggedIn_;
+}
+
+bool StompClientEngine::awaitReceipt(int receipt, int timeoutMs)
+{
+    std::unique_lock<std::mutex> lock(sessionMutex_);
+    Session &session = *session_;
+    return sessionChanged_.wait_for(lock, std::chrono::milliseconds(timeoutMs),
+                                    [&session, receipt]() { return session.receivedReceipt >= receipt || session.ended; }) &&
+           session.receivedReceipt >= receipt;
+}
+
+bool StompClientEngine::awaitReceipts(int timeoutMs)
+{
+    if (!session_)
+        return false;
+    return awaitReceipt(session_->requestedReceipt, timeoutMs);
+}
+
+bool StompClientEngine::subscribe(const std::string &channel)
+{
+    if (!canSend() || session_->subscriptions.count(channel) != 0)
+        return false;
+    // Ids stay unique across the sessions of the engine
+    std::string subscriptionIdStr = std::to_string(nextSubscriptionId_++);
+    session_->subscriptions[channel] = subscriptionIdStr;
+
+    std::string subscribeFrame = session_->protocol->createSubscribeFrame(channel, subscriptionIdStr);
+    session_->requestedReceipt = session_->protocol->lastReceipt();
+    return sendFrames(subscribeFrame + '\0');
+}
+
+bool StompClientEngine::unsubscribe(const std::string &channel)
+{
+    if (!canSend())
+        return false;
+    auto it = session_->subscriptions.find(channel);
+    if (it == session_->subscriptions.end())
+        return false;
+
+    std::string unsubscribeFrame = session_->protocol->createUnsubscribeFrame(it->second);
+    session_->subscriptions.erase(it);
+    return sendFrames(unsubscribeFrame + '\0');
+}
+
+bool StompClientEngine::publish(const std::string &channel, const std::vector<Event> &events, bool withReceipt)
+{
+    if (!canSend())
+        return false;
+    if (events.empty())
+        return true;
+    // The frames go out back to back in a single write instead of two writes per frame
+    std::string frames;
+    for (std::size_t i = 0; i < events.size(); ++i) {
+        bool receipt = withReceipt && i + 1 == events.size();
+        frames += session_->protocol->createSendFrame(channel, serializeEvent(events[i]), receipt);
+        frames += '\0';
+    }
+    if (withReceipt)
+        session_->requestedReceipt = session_->protocol->lastReceipt();
+    return sendFrames(frames);
+}
+
+bool StompClientEngine::disconnect()
+{
+    if (!canSend())
+        return false;
+
+    std::string disconnectFrame = session_->protocol->createDisconnectFrame();
+    if (sendFrames(disconnectFrame + '\0'))
+        awaitReceipt(session_->protocol->lastReceipt(), DISCONNECT_TIMEOUT_MS);
+
+    if (!rollups_.save(rollupFileName(session_->username)))
+        warn("Failed to save rollups to file: " + rollupFileName(session_->username));
+    endSession();
+
+    eventStore_.clear();
+    summaryCache_.clear();
+    streamStats_.clear();
+    rollups_.clear();
+    deduplicator_.clear();
+    deliveryLatency_.clear();
+    return true;
+}
+
+bool StompClientEngine::writeSummary(const SummaryQuery &query)
+{
+    // Reports are sorted by date_time, then by event_name; a repeated summary reuses the reports already rendered
+    return summaryCache_.write(eventStore_.snapshot(), query);
+}
+
+std::vector<RollupTable::Row> StompClientEngine::rollup(const std::string &channel, const std::string &city,
+                                                        RollupResolution resolution, int from, int to) const
+{
+    return rollups_.query(channel, city, resolution, from, to);
+}
+
+void StompClientEngine::login(const std::string &line)
+{
+    if (canSend()) {
+        warn("You are already logged in. Please log out first.");
+        return;
+    }
+
+    //Parse the login command
+    std::istringstream userInputStream(line);
+    std::string command, hostPort, username, password;
+    userInputStream >> command >> hostPort >> username >> password;
+    //handeling host&port "127.0.0.1:7777" (example for template)
+    auto colonPos = hostPort.find(':');
+    int port = 0;
+    try {
+        if (colonPos != std::string::npos)
+            port = std::stoi(hostPort.substr(colonPos + 1)); //std::stoi - Convert string to integer
+    } catch (const std::exception &) {
+        colonPos = std::string::npos;
+    }
+    if (colonPos == std::string::npos) {
+        warn("Invalid login command. Usage: login <host:port> <username> <password>");
+        return;
+    }
+
+    if (!connect(hostPort.substr(0, colonPos), port, username, password)) {
+        warn("Could not connect to server.");
+        return;
+    }
+    say("Login request sent to server.");
+}
+
+void StompClientEngine::join(const std::string &line)
+{
+    if (!canSend()) {
+        warn("You must be logged in to join a channel.");
+        return;
+    }
+
+    std::string channelName = line.substr(5);
+    if (channelName.empty()) {
+        warn("Invalid join command. Usage: join <channel_name>");
+        return;
+    }
+    if (!subscribe(channelName))
+        warn("Already subscribed to channel: " + channelName);
+}
+
+void StompClientEngine::exitChannel(const std::string &line)
+{
+    if (!canSend()) {
+        warn("User must be logged in before exiting from channel. ");
+        return;
+    }
+
+    //Parse the channel name, structure: exit {channel_name}
+    std::string channel_name = line.substr(5);
+    if (channel_name.empty()) {
+        warn("Invalid exit command. Structure: exit {channel_name}");
+        return;
+    }
+    if (!unsubscribe(channel_name))
+        warn("you are not subscribed to channel: " + channel_name);
+}
+
+void StompClientEngine::report(const std::string &line)
+{
+    if (!canSend()) {
+        warn("You must be logged in to send a report.");
+        return;
+    }
+
+    std::string fileName = line.substr(7);
+    if (fileName.empty()) {
+        warn("Invalid report command. Usage: report <file_name>");
+        return;
+    }
+
+    try {
+        names_and_events parsedData = parseEventsFile(fileName);
+        if (!publish(parsedData.channel_name, parsedData.events))
+            warn("Failed to send report to server.");
+    } catch (const std::exception &ex) {
+        warn("Failed to process report file '" + fileName + "': " + ex.what());
+    }
+}
+
+void StompClientEngine::summary(const std::string &line)
+{
+    if (!loggedIn_) {
+        say("User must be logged in for doing a summary...");
+        return;
+    }
+
+    //Parse the summary command, structure: summary {channel_name} {user} {file} [filters...]
+    SummaryQuery query;
+    std::string error;
+    if (!SummaryQuery::parse(line, query, error)) {
+        warn(error);
+        return;
+    }
+
+    // Works on a snapshot, so the reader thread keeps storing new events meanwhile
+    EventStore::Snapshot snapshot = eventStore_.snapshot();
+    if (!snapshot.hasChannel(query.channel)) {
+        warn("No events found for channel: " + query.channel);
+        return;
+    }
+
+    // Reports are sorted by date_time, then by event_name; a repeated summary reuses the reports already rendered
+    if (!summaryCache_.write(snapshot, query))
+        warn("Failed to write summary to file: " + query.file);
+}
+
+void StompClientEngine::summaryAll(const std::string &line)
+{
+    // Structure: summary-all {directory} [filters...], one file per (channel, user) series
+    if (!loggedIn_) {
+        say("User must be logged in for doing a summary...");
+        return;
+    }
+
+    SummaryQuery filters;
+    std::string error;
+    if (!SummaryQuery::parseAll(line, filters, error)) {
+        warn(error);
+        return;
+    }
+
+    EventStore::Snapshot snapshot = eventStore_.snapshot();
+    ThreadPool pool;
+    SummaryExportResult result = writeAllSummaries(snapshot, filters, pool);
+    for (const std::string &file : result.failed)
+        warn("Failed to write summary to file: " + file);
+    say("Wrote " + std::to_string(result.written) + " summaries to " + filters.file);
+}
+
+void StompClientEngine::histogram(const std::string &line)
+{
+    // Structure: histogram {channel_name} {user|*} {bucket width} [filters...]
+    SummaryQuery query;
+    int bucketSeconds = 0;
+    std::string error;
+    if (!SummaryQuery::parseHistogram(line, query, bucketSeconds, error)) {
+        warn(error);
+        return;
+    }
+
+    EventStore::Snapshot snapshot = eventStore_.snapshot();
+    std::vector<EventStore::Snapshot::HistogramBucket> buckets;
+    if (!snapshot.histogram(query, bucketSeconds, buckets)) {
+        warn("Too many buckets, use a wider bucket or a shorter time range.");
+        return;
+    }
+    if (buckets.empty()) {
+        say("No matching events.");
+        return;
+    }
+    std::ostringstream out;
+    for (const EventStore::Snapshot::HistogramBucket &bucket : buckets)
+        appendCounts(out, bucket.start, bucket.counts);
+    std::string text = out.str();
+    text.pop_back(); // say() ends the last line
+    say(text);
+}
+
+void StompClientEngine::rollup(const std::string &line)
+{
+    // Structure: rollup {channel_name} {city|*} {hour|day} [--from TIME] [--to TIME]
+    const char *usage = "Invalid rollup command. Usage: rollup <channel_name> <city|*> <hour|day> [--from TIME] [--to TIME]";
+    std::vector<std::string> args = splitCommandArgs(line);
+    if (args.size() < 4 || args.size() % 2 != 0 || (args[3] != "hour" && args[3] != "day")) {
+        warn(usage);
+        return;
+    }
+    int from = INT_MIN, to = INT_MAX;
+    bool valid = true;
+    for (std::size_t i = 4; i < args.size() && valid; i += 2) {
+        if (args[i] == "--from")
+            valid = parseDateTime(args[i + 1], from);
+        else if (args[i] == "--to")
+            valid = parseDateTime(args[i + 1], to);
+        else
+            valid = false;
+    }
+    if (!valid) {
+        warn(usage);
+        return;
+    }
+
+    std::vector<RollupTable::Row> rows = rollup(args[1], args[2] == "*" ? std::string() : args[2],
+                                                args[3] == "hour" ? RollupResolution::Hour : RollupResolution::Day,
+                                                from, to);
+    if (rows.empty()) {
+        say("No matching events.");
+        return;
+    }
+    std::ostringstream out;
+    for (const RollupTable::Row &row : rows)
+        appendCounts(out, row.start, row.counts);
+    std::string text = out.str();
+    text.pop_back();
+    say(text);
+}
+
+void StompClientEngine::search(const std::string &line)
+{
+    // Structure: search [--limit N] {words and "quoted phrases"}
+    std::string text = line.substr(7);
+    std::size_t limit = 10;
+    if (text.rfind("--limit ", 0) == 0) {
+        std::istringstream limitStream(text.substr(8));
+        long long requested = 0;
+        if (!(limitStream >> requested) || requested <= 0) {
+            warn("Invalid search command. Usage: search [--limit N] <words or \"phrase\">");
+            return;
+        }
+        limit = static_cast<std::size_t>(requested);
+        std::getline(limitStream, text);
+    }
+
+    EventStore::Snapshot snapshot = eventStore_.snapshot();
+    std::vector<EventStore::Snapshot::SearchHit> hits = snapshot.search(text, limit);
+    if (hits.empty()) {
+        say("No matching events.");
+        return;
+    }
+    std::ostringstream out;
+    int rank = 1;
+    for (const EventStore::Snapshot::SearchHit &hit : hits) {
+        const Event &event = snapshot.get(hit.id);
+        char score[32];
+        std::snprintf(score, sizeof(score), "%.2f", hit.score);
+        if (rank > 1)
+            out << "\n";
+        out << rank++ << ". [" << score << "] "
+            << event.get_channel_name() << "/" << event.getEventOwnerUser() << " "
+            << epochToDate(event.get_date_time()) << " " << event.get_city() << " - "
+            << event.get_name() << ": " << event.get_description();
+    }
+    say(out.str());
+}
+
+void StompClientEngine::stats(const std::string &line)
+{
+    // Structure: stats [channel_name]; without a channel, the client's own metrics
+    std::ostringstream out;
+    if (line == "stats") {
+        metrics_.render(out);
+        std::string text = out.str();
+        text.pop_back();
+        say(text);
+        return;
+    }
+    std::string channelName = line.substr(6);
+    if (!streamStats_.render(channelName, out)) {
+        warn("No events received on channel: " + channelName);
+        return;
+    }
+    std::string text = out.str();
+    text.pop_back(); // say() ends the last line
+    say(text);
+}
+
+void StompClientEngine::latency(const std::string &line)
+{
+    // Structure: latency [channel_name]
+    std::string channelName = line.size() > 8 ? line.substr(8) : "";
+    std::ostringstream out;
+    if (!deliveryLatency_.render(channelName, out)) {
+        warn(channelName.empty() ? "No messages received." : "No messages received on channel: " + channelName);
+        return;
+    }
+    std::string text = out.str();
+    text.pop_back();
+    say(text);
+}
+
+void StompClientEngine::logout()
+{
+    if (!disconnect()) {
+        warn("You must be logged in to log out.");
+        return;
+    }
+    say("Logout successful. You can log in again.");
+}
+
+void StompClientEngine::quit()
+{
+    if (canSend())
+        logout();
+    terminate_ = true;
+}
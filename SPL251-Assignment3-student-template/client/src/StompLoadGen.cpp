@@ -0,0 +1,407 @@
+#include "../include/ConnectionHandler.h"
+#include "../include/DeliveryLatency.h"
+#include "../include/StompProtocol.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <ctime>
+#include <memory>
+#include <sstream>
+#include <thread>
+#include <unistd.h>
+
+// Load generator: opens N sessions to a STOMP server, subscribes every one to the same M channels and has
+// each publish synthetic reports round robin over them, paced to a total rate or as fast as its socket takes
+// them. Every report is stamped (see DeliveryLatency), so each delivery to each session is timed and
+// checked for gaps. Runs against the Java StompServer or any broker forwarding SEND headers.
+
+static const char *USAGE = " <host:port> [--sessions <n>] [--channels <m>] [--rate <reports/s>] [--seconds <s>]\n"
+                           "  [--body-size <bytes>] [--drain <s>] [--prefix <name>] [--metrics-file <file>]\n"
+                           "  --rate 0 (the default) publishes open loop, as fast as each socket takes the frames";
+
+// How long to wait for the receipts of the subscriptions, and of each DISCONNECT
+static const int HANDSHAKE_TIMEOUT_MS = 5000;
+
+struct LoadOptions {
+    std::string host;
+    short port;
+    int sessions;
+    int channels;
+    double rate;          // reports per second over every session; 0 is unthrottled
+    double seconds;       // of publishing
+    double drainSeconds;  // longest wait for the deliveries still on their way
+    std::size_t bodySize; // the description is padded to reach it
+    std::string prefix;   // of the user and channel names
+    std::string metricsFile;
+
+    LoadOptions()
+        : host(), port(0), sessions(4), channels(2), rate(0), seconds(10), drainSeconds(5), bodySize(0),
+          prefix("loadgen"), metricsFile() {}
+};
+
+// Shared by every session
+struct LoadCounters {
+    MetricsRegistry::Counter sent;
+    MetricsRegistry::Counter delivered;
+    MetricsRegistry::Counter connectErrors;
+    MetricsRegistry::Counter errorFrames;
+    MetricsRegistry::Counter sendErrors;
+    MetricsRegistry::Counter connectionsLost;
+
+    explicit LoadCounters(MetricsRegistry &metrics)
+        : sent(metrics.counter("stomp_loadgen_reports_sent_total", "Reports published.")),
+          delivered(metrics.counter("stomp_loadgen_messages_delivered_total", "MESSAGEs received, over every session.")),
+          connectErrors(metrics.counter("stomp_loadgen_errors_total", "Failures, by kind.", "kind=\"connect\"")),
+          errorFrames(metrics.counter("stomp_loadgen_errors_total", "Failures, by kind.", "kind=\"error_frame\"")),
+          sendErrors(metrics.counter("stomp_loadgen_errors_total", "Failures, by kind.", "kind=\"send\"")),
+          connectionsLost(metrics.counter("stomp_loadgen_errors_total", "Failures, by kind.", "kind=\"connection_lost\"")) {}
+};
+
+static std::string channelName(const LoadOptions &options, int channel)
+{
+    return options.prefix + "-" + std::to_string(channel);
+}
+
+// A report the client's Event(frame_body) parses, description padded to bodySize bytes in all
+static std::string reportBody(const LoadOptions &options, const std::string &user)
+{
+    std::ostringstream body;
+    body << "user: " << user << "\n"
+         << "event name: load test\n"
+         << "city: Loopback\n"
+         << "date time: " << std::time(nullptr) << "\n"
+         << "general information:\n"
+         << "  active: true\n"
+         << "  forces_arrival_at_scene: false\n"
+         << "description: synthetic report";
+    std::string text = body.str();
+    if (text.size() < options.bodySize)
+        text.append(options.bodySize - text.size(), '.');
+    return text;
+}
+
+class LoadSession
+{
+public:
+    LoadSession(const LoadOptions &options, const std::string &user, Logger &logger, MetricsRegistry &metrics,
+                LoadCounters &counters)
+        : options_(options), user_(user), logger_(logger), counters_(counters), latency_(metrics),
+          connection_(options.host, options.port, logger, metrics), protocol_(connection_, logger, metrics),
+          reader_(), publisher_(), receipt_(0), closing_(false), maxLag_(0) {}
+
+    ~LoadSession()
+    {
+        close();
+    }
+
+    LoadSession(const LoadSession &) = delete;
+    LoadSession &operator=(const LoadSession &) = delete;
+
+    // Logs in, subscribes to every channel and starts reading. False when the session is unusable.
+    bool start()
+    {
+        std::string frame;
+        if (!connection_.connect() || !send(protocol_.createConnectFrame(options_.host, user_, "loadgen")) ||
+            !connection_.getFrameAscii(frame, '\0')) {
+            counters_.connectErrors.add();
+            return false;
+        }
+        if (frame.compare(0, 9, "CONNECTED") != 0) {
+            counters_.connectErrors.add();
+            STOMP_LOG(logger_, LogLevel::Warn, LogCategory::Client, user_ << ": login refused: " << frame);
+            return false;
+        }
+        protocol_.setStamping(true);
+        std::string frames;
+        for (int channel = 0; channel < options_.channels; ++channel) {
+            frames += protocol_.createSubscribeFrame(channelName(options_, channel), std::to_string(channel));
+            frames += '\0';
+        }
+        if (!connection_.sendBytes(frames.data(), frames.size())) {
+            counters_.connectErrors.add();
+            return false;
+        }
+        reader_ = std::thread(&LoadSession::readFrames, this);
+        return true;
+    }
+
+    // Whether the server acknowledged every frame asked a receipt for so far
+    bool acknowledged() const { return receipt_.load() >= protocol_.lastReceipt(); }
+
+    // Publishes from a thread of its own at interval apart (0: back to back), from first until end
+    void startPublishing(std::chrono::nanoseconds interval, std::chrono::steady_clock::time_point first,
+                         std::chrono::steady_clock::time_point end)
+    {
+        publisher_ = std::thread(&LoadSession::publish, this, interval, first, end);
+    }
+
+    void stopPublishing()
+    {
+        if (publisher_.joinable())
+            publisher_.join();
+    }
+
+    const DeliveryLatency &latency() const { return latency_; }
+
+    // How far behind its schedule the publisher fell at worst, in nanoseconds
+    std::uint64_t maxLag() const { return maxLag_; }
+
+    // Sends DISCONNECT and waits a while for its receipt, then closes the connection
+    void close()
+    {
+        stopPublishing();
+        if (!reader_.joinable())
+            return;
+        closing_ = true;
+        if (send(protocol_.createDisconnectFrame())) {
+            std::chrono::steady_clock::time_point deadline =
+                std::chrono::steady_clock::now() + std::chrono::milliseconds(HANDSHAKE_TIMEOUT_MS);
+            while (!acknowledged() && std::chrono::steady_clock::now() < deadline)
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        connection_.shutdown();
+        reader_.join();
+        connection_.close();
+    }
+
+private:
+    const LoadOptions &options_;
+    const std::string user_;
+    Logger &logger_;
+    LoadCounters &counters_;
+    DeliveryLatency latency_; // sequences are per receiver, the metrics it records are shared
+    ConnectionHandler connection_;
+    StompProtocol protocol_;
+    std::thread reader_;
+    std::thread publisher_;
+    std::atomic<int> receipt_;   // the highest receipt id received
+    std::atomic<bool> closing_;  // the connection ending is expected
+    std::uint64_t maxLag_;       // written by the publisher, read once it is joined
+
+    // frame is the builder's output, its '\0' included
+    bool send(const std::string &frame)
+    {
+        return connection_.sendBytes(frame.c_str(), frame.size() + 1);
+    }
+
+    // The publisher thread
+    void publish(std::chrono::nanoseconds interval, std::chrono::steady_clock::time_point first,
+                 std::chrono::steady_clock::time_point end)
+    {
+        const std::string body = reportBody(options_, user_);
+        std::chrono::steady_clock::time_point due = first;
+        std::this_thread::sleep_until(first);
+        for (int channel = 0; std::chrono::steady_clock::now() < end; channel = (channel + 1) % options_.channels) {
+            if (interval.count() > 0) {
+                std::this_thread::sleep_until(due);
+                std::uint64_t lag = elapsedNanoseconds(due);
+                if (lag > maxLag_)
+                    maxLag_ = lag;
+                due += interval;
+            }
+            if (!send(protocol_.createSendFrame(channelName(options_, channel), body))) {
+                counters_.sendErrors.add();
+                return;
+            }
+            counters_.sent.add();
+        }
+    }
+
+    // The reader thread: runs until the connection closes
+    void readFrames()
+    {
+        std::vector<std::string> frames;
+        while (true) {
+            frames.clear();
+            if (!connection_.getFrames(frames)) {
+                if (!closing_) {
+                    counters_.connectionsLost.add();
+                    STOMP_LOG(logger_, LogLevel::Warn, LogCategory::Client, user_ << ": connection lost");
+                }
+                return;
+            }
+            std::int64_t receivedAt = DeliveryLatency::now(); // the frames of one read arrived together
+            for (const std::string &frame : frames) {
+                if (frame.compare(0, 7, "MESSAGE") == 0) {
+                    latency_.add(headerValue(frame, "destination"), headerValue(frame, "sent-at"),
+                                 headerValue(frame, "sequence"), receivedAt);
+                    counters_.delivered.add();
+                } else if (frame.compare(0, 7, "RECEIPT") == 0) {
+                    int receipt = std::atoi(headerValue(frame, "receipt-id").c_str());
+                    protocol_.receiptReceived(receipt);
+                    if (receipt > receipt_)
+                        receipt_ = receipt;
+                } else if (frame.compare(0, 5, "ERROR") == 0) {
+                    counters_.errorFrames.add();
+                    STOMP_LOG(logger_, LogLevel::Warn, LogCategory::Client, user_ << ": server ERROR: " << frame);
+                }
+            }
+        }
+    }
+};
+
+static bool parseOptions(int argc, char *argv[], LoadOptions &options)
+{
+    if (argc < 2)
+        return false;
+    std::string address = argv[1];
+    std::size_t colon = address.find(':');
+    if (colon == std::string::npos)
+        return false;
+    options.host = address.substr(0, colon);
+    options.port = static_cast<short>(std::atoi(address.c_str() + colon + 1));
+    for (int i = 2; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (i + 1 >= argc)
+            return false;
+        const char *value = argv[++i];
+        if (arg == "--sessions")
+            options.sessions = std::atoi(value);
+        else if (arg == "--channels")
+            options.channels = std::atoi(value);
+        else if (arg == "--rate")
+            options.rate = std::atof(value);
+        else if (arg == "--seconds")
+            options.seconds = std::atof(value);
+        else if (arg == "--drain")
+            options.drainSeconds = std::atof(value);
+        else if (arg == "--body-size")
+            options.bodySize = std::strtoul(value, nullptr, 10);
+        else if (arg == "--prefix")
+            options.prefix = value;
+        else if (arg == "--metrics-file")
+            options.metricsFile = value;
+        else
+            return false;
+    }
+    return options.port > 0 && options.sessions > 0 && options.channels > 0 && options.rate >= 0 &&
+           options.seconds > 0 && options.drainSeconds >= 0;
+}
+
+static double secondsSince(std::chrono::steady_clock::time_point start)
+{
+    return elapsedNanoseconds(start) / 1e9;
+}
+
+int main(int argc, char *argv[])
+{
+    Logger &logger = Logger::console();
+    logger.setLevel(LogCategory::Connection, LogLevel::Warn); // one "Starting connect" per session is noise
+    LoadOptions options;
+    if (!parseOptions(argc, argv, options)) {
+        logger.log(LogLevel::Error, LogCategory::Client, std::string("Usage: ") + argv[0] + USAGE);
+        logger.flush();
+        return 1;
+    }
+
+    MetricsRegistry metrics;
+    LoadCounters counters(metrics);
+    if (!options.metricsFile.empty() && !metrics.dumpEvery(options.metricsFile, 1)) {
+        logger.log(LogLevel::Error, LogCategory::Client, "Cannot write metrics file: " + options.metricsFile);
+        logger.flush();
+        return 1;
+    }
+
+    // Users unique to this run, so a server still holding an earlier run's logins lets them in
+    std::vector<std::unique_ptr<LoadSession>> sessions;
+    for (int i = 0; i < options.sessions; ++i) {
+        std::string user = options.prefix + "-" + std::to_string(getpid()) + "-" + std::to_string(i);
+        std::unique_ptr<LoadSession> session(new LoadSession(options, user, logger, metrics, counters));
+        if (session->start())
+            sessions.push_back(std::move(session));
+    }
+    if (sessions.empty()) {
+        logger.log(LogLevel::Error, LogCategory::Client, "No session could log in to " + std::string(argv[1]));
+        logger.flush();
+        return 1;
+    }
+    // The totals every session's DeliveryLatency records to
+    MetricsRegistry::Histogram deliveryLatency = sessions.front()->latency().latencyMetric();
+    MetricsRegistry::Counter missing = sessions.front()->latency().missingMetric();
+    MetricsRegistry::Counter late = sessions.front()->latency().lateMetric();
+    // Reports published before every subscription is in place would look lost
+    std::chrono::steady_clock::time_point deadline =
+        std::chrono::steady_clock::now() + std::chrono::milliseconds(HANDSHAKE_TIMEOUT_MS);
+    for (std::unique_ptr<LoadSession> &session : sessions) {
+        while (!session->acknowledged() && std::chrono::steady_clock::now() < deadline)
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    std::ostringstream plan;
+    plan << sessions.size() << " of " << options.sessions << " sessions connected, " << options.channels
+         << " channels each, publishing for " << options.seconds << "s ";
+    if (options.rate > 0)
+        plan << "at " << options.rate << " reports/s";
+    else
+        plan << "open loop";
+    logger.log(LogLevel::Info, LogCategory::Client, plan.str());
+
+    // Each session publishes its share of the rate, their schedules staggered across the interval
+    std::chrono::nanoseconds interval(0);
+    if (options.rate > 0 && !sessions.empty())
+        interval = std::chrono::nanoseconds(static_cast<std::int64_t>(1e9 * sessions.size() / options.rate));
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    std::chrono::steady_clock::time_point end =
+        start + std::chrono::nanoseconds(static_cast<std::int64_t>(options.seconds * 1e9));
+    for (std::size_t i = 0; i < sessions.size(); ++i)
+        sessions[i]->startPublishing(interval, start + interval * static_cast<int>(i) / static_cast<int>(sessions.size()), end);
+
+    // A progress line a second while publishing
+    std::uint64_t lastSent = 0, lastDelivered = 0;
+    while (std::chrono::steady_clock::now() < end) {
+        std::this_thread::sleep_until(std::min(end, std::chrono::steady_clock::now() + std::chrono::seconds(1)));
+        std::uint64_t sent = metrics.value(counters.sent), delivered = metrics.value(counters.delivered);
+        STOMP_LOG(logger, LogLevel::Info, LogCategory::Client,
+                  static_cast<int>(secondsSince(start)) << "s: sent " << sent - lastSent << ", delivered "
+                                                        << delivered - lastDelivered);
+        lastSent = sent;
+        lastDelivered = delivered;
+    }
+    for (std::unique_ptr<LoadSession> &session : sessions)
+        session->stopPublishing();
+    double publishSeconds = secondsSince(start);
+
+    // Every session receives every report
+    std::uint64_t sent = metrics.value(counters.sent);
+    std::uint64_t expected = sent * sessions.size();
+    std::chrono::steady_clock::time_point drainEnd =
+        std::chrono::steady_clock::now() + std::chrono::nanoseconds(static_cast<std::int64_t>(options.drainSeconds * 1e9));
+    while (metrics.value(counters.delivered) < expected && std::chrono::steady_clock::now() < drainEnd)
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    double deliverSeconds = secondsSince(start);
+    std::uint64_t delivered = metrics.value(counters.delivered);
+    std::uint64_t maxLag = 0;
+    for (std::unique_ptr<LoadSession> &session : sessions) {
+        session->close();
+        maxLag = std::max(maxLag, session->maxLag());
+    }
+    sessions.clear();
+    metrics.stopDumping();
+
+    MetricsRegistry::HistogramSnapshot timed = metrics.snapshot(deliveryLatency);
+    std::uint64_t lost = expected > delivered ? expected - delivered : 0;
+    std::uint64_t errors = metrics.value(counters.connectErrors) + metrics.value(counters.errorFrames) +
+                           metrics.value(counters.sendErrors) + metrics.value(counters.connectionsLost) + lost;
+    std::ostringstream report;
+    report << "Sent " << sent << " reports in " << publishSeconds << "s: " << sent / publishSeconds << "/s\n"
+           << "Delivered " << delivered << " of " << expected << " in " << deliverSeconds << "s: "
+           << delivered / deliverSeconds << "/s\n"
+           << "Delivery latency ";
+    if (timed.count == 0) {
+        report << "none timed\n";
+    } else {
+        report << "p50 " << formatDuration(timed.percentile(0.5)) << "  p90 " << formatDuration(timed.percentile(0.9))
+               << "  p99 " << formatDuration(timed.percentile(0.99)) << "  p99.9 "
+               << formatDuration(timed.percentile(0.999)) << "  max " << formatDuration(timed.max()) << "\n";
+    }
+    if (interval.count() > 0)
+        report << "Publishing fell behind schedule by up to " << formatDuration(maxLag) << "\n";
+    report << "Errors: " << metrics.value(counters.connectErrors) << " connect, "
+           << metrics.value(counters.errorFrames) << " ERROR frames, " << metrics.value(counters.sendErrors)
+           << " send, " << metrics.value(counters.connectionsLost) << " connections lost, " << lost
+           << " undelivered (" << metrics.value(missing) << " missing and " << metrics.value(late)
+           << " late by sequence)\n";
+    std::string text = report.str();
+    logger.log(LogLevel::Info, LogCategory::Client, text.substr(0, text.size() - 1));
+    logger.flush();
+    return errors == 0 ? 0 : 1;
+}
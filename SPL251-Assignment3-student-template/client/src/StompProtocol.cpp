@@ -1,8 +1,63 @@
 #include "../include/StompProtocol.h"
+#include "../include/DateFormatter.h"
+#include "../include/DeliveryLatency.h"
+#include <algorithm>
+#include <cstdio>
 #include <iostream>
+#include <random>
 #include <sstream>
 
-StompProtocol::StompProtocol(ConnectionHandler &handler) : connectionHandler(handler), subscriptions(), receiptCounter(0) {}
+enum { CONNECT_COMMAND, SEND_COMMAND, SUBSCRIBE_COMMAND, UNSUBSCRIBE_COMMAND, DISCONNECT_COMMAND };
+// 64 random bits in hex, telling this session's sequence numbers apart from any other sender's
+static std::string newStream()
+{
+    std::random_device device;
+    std::uint64_t bits = (std::uint64_t(device()) << 32) ^ device() ^
+                         std::chrono::steady_clock::now().time_since_epoch().count();
+    char text[17];
+    std::snprintf(text, sizeof(text), "%016llx", static_cast<unsigned long long>(bits));
+    return text;
+}
+
+static const char *COMMAND_LABELS[] = {"command=\"CONNECT\"", "command=\"SEND\"", "command=\"SUBSCRIBE\"",
+                                       "command=\"UNSUBSCRIBE\"", "command=\"DISCONNECT\""};
+
+StompProtocol::StompProtocol(ConnectionHandler &handler, Logger &logger, MetricsRegistry &metrics)
+    : connectionHandler(handler), logger(logger), subscriptions(), receiptCounter(0), framesSent(), frameBytesSent(),
+      receiptRoundTrip(metrics.histogram("stomp_receipt_round_trip_seconds",
+                                         "From building a frame that asks for a receipt to reading the RECEIPT.")),
+      receiptsMutex(), receiptsPending(), stamping(false), stream(newStream()), sequences()
+{
+    for (std::size_t i = 0; i < COMMANDS; ++i) {
+        framesSent[i] = metrics.counter("stomp_frames_sent_total", "Frames sent to the server, by command.",
+                                        COMMAND_LABELS[i]);
+        frameBytesSent[i] = metrics.counter("stomp_frame_bytes_sent_total",
+                                            "Bytes of the frames sent to the server, by command.", COMMAND_LABELS[i]);
+    }
+}
+
+std::string StompProtocol::counted(std::size_t command, std::string frame)
+{
+    framesSent[command].add();
+    frameBytesSent[command].add(frame.size() + 1);
+    return frame;
+}
+
+void StompProtocol::requestedReceipt(int id)
+{
+    std::lock_guard<std::mutex> lock(receiptsMutex);
+    receiptsPending[id] = std::chrono::steady_clock::now();
+}
+
+void StompProtocol::receiptReceived(int id)
+{
+    std::lock_guard<std::mutex> lock(receiptsMutex);
+    auto it = receiptsPending.find(id);
+    if (it == receiptsPending.end())
+        return;
+    receiptRoundTrip.record(elapsedNanoseconds(it->second));
+    receiptsPending.erase(it);
+}
 
 std::string StompProtocol::createConnectFrame(const std::string &host, const std::string &username, const std::string &password) {
     std::string frame = "CONNECT\n"
@@ -10,23 +65,33 @@ std::string StompProtocol::createConnectFrame(const std::string &host, const std
                         "host:stomp.cs.bgu.ac.il\n"
                         "login:" + username + "\n"
                         "passcode:" + password + "\n\n\0";
-    return frame;
+    return counted(CONNECT_COMMAND, frame);
 }
 
 
-std::string StompProtocol::createSendFrame(const std::string &destination, const std::string &message)
+std::string StompProtocol::createSendFrame(const std::string &destination, const std::string &message, bool withReceipt)
 {
-    return "SEND\n"
-           "destination:" + destination + "\n\n" +
-           message + "\n\0";
+    std::string headers;
+    if (withReceipt) {
+        headers = "receipt:" + std::to_string(++receiptCounter) + "\n";
+        requestedReceipt(receiptCounter);
+    }
+    if (stamping) {
+        headers += "sent-at:" + std::to_string(DeliveryLatency::now()) + "\n"
+                   "sequence:" + stream + "/" + std::to_string(++sequences[destination]) + "\n";
+    }
+    return counted(SEND_COMMAND, "SEND\n"
+                                 "destination:" + destination + "\n" + headers + "\n" +
+                                 message + "\n\0");
 }
 
 std::string StompProtocol::createSubscribeFrame(const std::string &destination, const std::string &id)
 {
-    return "SUBSCRIBE\n"
-           "destination:" + destination + "\n"
-           "id:" + id + "\n"
-           "receipt:" + std::to_string(++receiptCounter) + "\n\n\0";
+    requestedReceipt(++receiptCounter);
+    return counted(SUBSCRIBE_COMMAND, "SUBSCRIBE\n"
+                                      "destination:" + destination + "\n"
+                                      "id:" + id + "\n"
+                                      "receipt:" + std::to_string(receiptCounter) + "\n\n\0");
 }
 
 std::string StompProtocol::createUnsubscribeFrame(const std::string &id)
@@ -39,39 +104,57 @@ std::string StompProtocol::createUnsubscribeFrame(const std::string &id)
             break;
         }
     }
-    return "UNSUBSCRIBE\n"
-           "id:" + id + "\n\n\0";
+    return counted(UNSUBSCRIBE_COMMAND, "UNSUBSCRIBE\n"
+                                        "id:" + id + "\n\n\0");
 }
 
 std::string StompProtocol::createDisconnectFrame()
 {
-    return "DISCONNECT\n"
-           "receipt:77\n\n\0";
+    requestedReceipt(++receiptCounter);
+    return counted(DISCONNECT_COMMAND, "DISCONNECT\n"
+                                       "receipt:" + std::to_string(receiptCounter) + "\n\n\0");
 }
 
 void StompProtocol::processServerMessage(const std::string &message)
 {
     if (message.find("CONNECTED") != std::string::npos)
     {
-        std::cout << "Connected successfully to the server!" << std::endl;
+        logger.log(LogLevel::Info, LogCategory::Protocol, "Connected successfully to the server!");
     }
     else if (message.find("MESSAGE") != std::string::npos)
     {
         // diagnosed msg from channel
         std::string body = message.substr(message.find("\n\n") + 2);//change the +2
         
-        std::cout << "New message received: " << body << std::endl;
+        STOMP_LOG(logger, LogLevel::Info, LogCategory::Protocol, "New message received: " << body);
     }
     else if (message.find("RECEIPT") != std::string::npos)
     {
-        std::cout << "Action acknowledged by the server." << std::endl;
+        logger.log(LogLevel::Info, LogCategory::Protocol, "Action acknowledged by the server.");
     }
     else if (message.find("ERROR") != std::string::npos)
     {
-        std::cerr << "Error received from server: " << message << std::endl;
+        STOMP_LOG(logger, LogLevel::Error, LogCategory::Protocol, "Error received from server: " << message);
     }
     else
     {
-        std::cerr << "Unknown message received: " << message << std::endl;
+        STOMP_LOG(logger, LogLevel::Warn, LogCategory::Protocol, "Unknown message received: " << message);
     }
-}
\ No newline at end of file
+}
+
+std::string epochToDate(int epoch) {
+    return DateFormatter::format(epoch); // "DD/MM/YY HH:MM" in local time, thread-safe
+}
+
+// The value of header name in frame's header block, or "" when it has none
+std::string headerValue(const std::string &frame, const std::string &name)
+{
+    // Only the header block is searched, a missing header costs no scan of the body
+    std::string::const_iterator headersEnd = frame.begin() + std::min(frame.find("\n\n"), frame.size());
+    std::string key = "\n" + name + ":";
+    std::string::const_iterator found = std::search(frame.begin(), headersEnd, key.begin(), key.end());
+    if (found == headersEnd)
+        return "";
+    std::size_t pos = found - frame.begin() + key.size();
+    return frame.substr(pos, frame.find('\n', pos) - pos);
+}
@@ -0,0 +1,73 @@
+#include "../include/StompScript.h"
+#include <fstream>
+#include <map>
+
+static bool startsWith(const std::string &line, const char *prefix)
+{
+    return line.rfind(prefix, 0) == 0;
+}
+
+static StompScript::Kind commandKind(const std::string &line)
+{
+    if (startsWith(line, "login "))
+        return StompScript::Kind::Login;
+    if (startsWith(line, "report "))
+        return StompScript::Kind::Report;
+    if (startsWith(line, "join ") || startsWith(line, "exit ") || line == "logout" || line == "exit")
+        return StompScript::Kind::Session;
+    if (startsWith(line, "summary ") || startsWith(line, "summary-all ") || startsWith(line, "histogram ") ||
+        startsWith(line, "rollup ") || startsWith(line, "search ") || startsWith(line, "stats ") || line == "stats" ||
+        startsWith(line, "latency ") || line == "latency")
+        return StompScript::Kind::Query;
+    return StompScript::Kind::Other;
+}
+
+StompScript::StompScript() : commands_() {}
+
+bool StompScript::load(const std::string &path, std::string &error)
+{
+    std::ifstream in(path.c_str());
+    if (!in) {
+        error = path + ": cannot read script";
+        return false;
+    }
+
+    std::vector<Command> commands;
+    std::map<std::string, std::shared_ptr<const names_and_events>> reports; // by event file
+    std::size_t lastReport = 0;
+    bool reportPending = false; // a report since the last query
+    std::string line;
+    for (int lineNumber = 1; std::getline(in, line); ++lineNumber) {
+        if (!line.empty() && line.back() == '\r')
+            line.pop_back();
+        if (line.empty() || line[0] == '#')
+            continue;
+
+        Command command;
+        command.kind = commandKind(line);
+        command.line = line;
+        if (command.kind == Kind::Report) {
+            std::string fileName = line.substr(7);
+            std::shared_ptr<const names_and_events> &report = reports[fileName];
+            if (!report) {
+                try {
+                    report = std::make_shared<names_and_events>(parseEventsFile(fileName));
+                } catch (const std::exception &ex) {
+                    error = path + ":" + std::to_string(lineNumber) + ": Failed to process report file '" +
+                            fileName + "': " + ex.what();
+                    return false;
+                }
+            }
+            command.report = report;
+            lastReport = commands.size();
+            reportPending = true;
+        } else if (command.kind == Kind::Query && reportPending) {
+            // Receipts come back in order, so one on the last report covers every report before it
+            commands[lastReport].receipt = true;
+            reportPending = false;
+        }
+        commands.push_back(command);
+    }
+    commands_.swap(commands);
+    return true;
+}
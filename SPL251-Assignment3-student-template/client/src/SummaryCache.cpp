@@ -0,0 +1,113 @@
+#include "../include/SummaryCache.h"
+
+// Everything but the output file, which does not change the bytes written
+static std::string cacheKey(const SummaryQuery &query)
+{
+    std::string key;
+    for (const std::string *field : {&query.channel, &query.user, &query.city, &query.eventName, &query.infoKey,
+                                     &query.infoValue}) {
+        key += *field;
+        key += '\0';
+    }
+    key += query.hasFrom ? std::to_string(query.from) : "-";
+    key += '\0';
+    key += query.hasTo ? std::to_string(query.to) : "-";
+    key += '\0';
+    key += static_cast<char>('0' + static_cast<int>(query.format));
+    return key;
+}
+
+SummaryCache::SummaryCache() : mutex_(), entries_(), bytes_(0), uses_(0), renderer_(), file_() {}
+
+// Appends the reports of ids to entry, numbered after the ones it has
+void SummaryCache::render(const EventStore::Snapshot &snapshot, const SummaryQuery &query,
+                          const std::vector<EventId> &ids, Entry &entry)
+{
+    std::vector<const Event *> events;
+    events.reserve(ids.size());
+    for (EventId id : ids)
+        events.push_back(&snapshot.get(id));
+    appendSummaryReports(renderer_, query, events, static_cast<long long>(entry.reports) + 1);
+
+    std::string rendered = renderer_.takeBuffer();
+    bytes_ += rendered.size();
+    if (entry.body.empty())
+        entry.body.swap(rendered);
+    else
+        entry.body += rendered;
+    entry.reports += ids.size();
+    if (!ids.empty())
+        entry.last = ids.back();
+}
+
+bool SummaryCache::write(const EventStore::Snapshot &snapshot, const SummaryQuery &query, Outcome *outcome)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::size_t version = snapshot.seriesVersion(query.channel, query.user);
+    EventId watermark = snapshot.watermark(query.channel);
+    Entry &entry = entries_[cacheKey(query)];
+    entry.lastUse = ++uses_;
+
+    Outcome result = Outcome::Reused;
+    if (!entry.valid || entry.version != version) {
+        std::vector<EventId> added;
+        bool appendable = entry.valid && entry.version < version;
+        if (appendable) {
+            added = snapshot.selectSince(query, entry.watermark);
+            // Reports are numbered in order, so new events may only go at the end
+            appendable = added.empty() || entry.reports == 0 || snapshot.reportOrderLess(entry.last, added.front());
+        }
+        if (appendable) {
+            for (EventId id : added) {
+                std::uint8_t flags = EventColumns::flagsOf(snapshot.get(id));
+                ++entry.counts.total;
+                entry.counts.active += (flags & EventColumns::ACTIVE) != 0;
+                entry.counts.forcesArrivalAtScene += (flags & EventColumns::FORCES_ARRIVAL_AT_SCENE) != 0;
+            }
+            render(snapshot, query, added, entry);
+            result = added.empty() ? Outcome::Reused : Outcome::Appended;
+        } else {
+            bytes_ -= entry.body.size();
+            entry.body.clear();
+            entry.reports = 0;
+            entry.counts = snapshot.aggregate(query);
+            render(snapshot, query, snapshot.select(query), entry);
+            result = Outcome::Rendered;
+        }
+        entry.valid = true;
+        entry.version = version;
+        entry.watermark = watermark;
+    }
+
+    bool ok = file_.open(query.file);
+    if (ok) {
+        appendSummaryHeader(file_, query, entry.counts);
+        file_.append(entry.body);
+        appendSummaryTrailer(file_, query);
+        ok = file_.close();
+    }
+    if (outcome != nullptr)
+        *outcome = result;
+    evict();
+    return ok;
+}
+
+void SummaryCache::evict()
+{
+    while (entries_.size() > 1 && (entries_.size() > MAX_ENTRIES || bytes_ > MAX_BYTES)) {
+        std::unordered_map<std::string, Entry>::iterator oldest = entries_.begin();
+        for (std::unordered_map<std::string, Entry>::iterator it = entries_.begin(); it != entries_.end(); ++it) {
+            if (it->second.lastUse < oldest->second.lastUse)
+                oldest = it;
+        }
+        bytes_ -= oldest->second.body.size();
+        entries_.erase(oldest);
+    }
+}
+
+void SummaryCache::clear()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    entries_.clear();
+    bytes_ = 0;
+}
@@ -0,0 +1,88 @@
+#include "../include/SummaryExport.h"
+#include "../include/SummaryWriter.h"
+#include <cerrno>
+#include <cctype>
+#include <mutex>
+#include <set>
+#include <sys/stat.h>
+
+// part with every byte but letters, digits, '-', '.' and UTF-8 escaped as %XX: '_' stays free to
+// separate the parts and the encoding is reversible
+static void appendSafe(std::string &name, const std::string &part)
+{
+    static const char HEX[] = "0123456789ABCDEF";
+    for (char ch : part) {
+        unsigned char byte = static_cast<unsigned char>(ch);
+        if (std::isalnum(byte) || ch == '-' || ch == '.' || byte >= 0x80) {
+            name.push_back(ch);
+        } else {
+            name.push_back('%');
+            name.push_back(HEX[byte >> 4]);
+            name.push_back(HEX[byte & 0xF]);
+        }
+    }
+}
+
+std::string summaryFileName(const std::string &channel, const std::string &user, SummaryFormat format)
+{
+    std::string name;
+    appendSafe(name, channel);
+    name.push_back('_');
+    appendSafe(name, user);
+    switch (format) {
+        case SummaryFormat::Json: return name + ".json";
+        case SummaryFormat::Csv: return name + ".csv";
+        default: return name + ".txt";
+    }
+}
+
+SummaryExportResult writeAllSummaries(const EventStore::Snapshot &snapshot, const SummaryQuery &filters,
+                                      ThreadPool &pool)
+{
+    SummaryExportResult result;
+    if (::mkdir(filters.file.c_str(), 0755) != 0 && errno != EEXIST) {
+        result.failed.push_back(filters.file);
+        return result;
+    }
+
+    std::mutex resultMutex;
+    std::vector<std::pair<std::string, std::string>> series = snapshot.series();
+    std::vector<std::string> paths;
+    std::set<std::string> taken;
+    for (const std::pair<std::string, std::string> &pair : series) {
+        std::string path = filters.file + "/" + summaryFileName(pair.first, pair.second, filters.format);
+        // Two tasks writing one file would clobber it; the encoding rules that out, this makes sure
+        if (!taken.insert(path).second) {
+            result.failed.push_back(path);
+            path.clear();
+        }
+        paths.push_back(path);
+    }
+    for (std::size_t i = 0; i < series.size(); ++i) {
+        if (paths[i].empty())
+            continue;
+        const std::pair<std::string, std::string> &pair = series[i];
+        const std::string &path = paths[i];
+        pool.submit([&snapshot, &filters, &result, &resultMutex, &pair, &path]() {
+            SummaryQuery query = filters;
+            query.channel = pair.first;
+            query.user = pair.second;
+            query.file = path;
+
+            std::vector<EventId> ids = snapshot.select(query);
+            std::vector<const Event *> events;
+            events.reserve(ids.size());
+            for (EventId id : ids)
+                events.push_back(&snapshot.get(id));
+            bool ok = writeSummary(query, events, snapshot.aggregate(query));
+
+            std::lock_guard<std::mutex> lock(resultMutex);
+            if (ok)
+                ++result.written;
+            else
+                result.failed.push_back(query.file);
+        });
+    }
+    pool.wait();
+    return result;
+}
@@ -0,0 +1,225 @@
+#include "../include/SummaryQuery.h"
+#include <cctype>
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+
+SummaryQuery::SummaryQuery() : channel(), user(), file(), hasFrom(false), hasTo(false), from(0), to(0),
+                               city(), eventName(), infoKey(), infoValue(), format(SummaryFormat::Text) {}
+
+bool SummaryQuery::hasAttributeFilters() const
+{
+    return !city.empty() || !eventName.empty() || !infoKey.empty();
+}
+
+bool SummaryQuery::isPlain() const
+{
+    return !hasFrom && !hasTo && !hasAttributeFilters();
+}
+
+std::vector<std::string> splitCommandArgs(const std::string &line)
+{
+    std::vector<std::string> args;
+    std::string current;
+    bool inQuotes = false;
+    bool hasToken = false;
+    for (char ch : line) {
+        if (ch == '"') {
+            inQuotes = !inQuotes;
+            hasToken = true; // "" is a valid empty argument
+        } else if (!inQuotes && std::isspace(static_cast<unsigned char>(ch))) {
+            if (hasToken) {
+                args.push_back(current);
+                current.clear();
+                hasToken = false;
+            }
+        } else {
+            current.push_back(ch);
+            hasToken = true;
+        }
+    }
+    if (hasToken)
+        args.push_back(current);
+    return args;
+}
+
+static bool parseNumber(const std::string &text, long long &value)
+{
+    if (text.empty())
+        return false;
+    char *end = nullptr;
+    value = std::strtoll(text.c_str(), &end, 10);
+    return *end == '\0';
+}
+
+bool parseDateTime(const std::string &text, int &epoch)
+{
+    long long number;
+    if (parseNumber(text, number)) {
+        epoch = static_cast<int>(number);
+        return true;
+    }
+
+    // DD/MM/YY HH:MM, the same shape epochToDate produces
+    std::tm tm = std::tm();
+    int day, month, year, hour, minute;
+    char tail;
+    if (std::sscanf(text.c_str(), "%d/%d/%d %d:%d%c", &day, &month, &year, &hour, &minute, &tail) != 5)
+        return false;
+    tm.tm_mday = day;
+    tm.tm_mon = month - 1;
+    tm.tm_year = (year < 100 ? year + 2000 : year) - 1900;
+    tm.tm_hour = hour;
+    tm.tm_min = minute;
+    tm.tm_isdst = -1; // let mktime work out DST
+    std::time_t time = std::mktime(&tm);
+    if (time == static_cast<std::time_t>(-1))
+        return false;
+    epoch = static_cast<int>(time);
+    return true;
+}
+
+// Parses durations such as 90, 30m, 2h or 7d into seconds
+static bool parseDuration(const std::string &text, long long &seconds)
+{
+    if (text.empty())
+        return false;
+    long long unit = 1;
+    std::string digits = text;
+    switch (text[text.size() - 1]) {
+        case 's': unit = 1; break;
+        case 'm': unit = 60; break;
+        case 'h': unit = 3600; break;
+        case 'd': unit = 86400; break;
+        default: digits.push_back('s'); break;
+    }
+    digits.erase(digits.size() - 1);
+    long long amount;
+    if (!parseNumber(digits, amount) || amount < 0)
+        return false;
+    seconds = amount * unit;
+    return true;
+}
+
+static const char *OPTIONS_USAGE = "[--from TIME] [--to TIME] [--last N{s|m|h|d}] "
+                                   "[--city NAME] [--event NAME] [--info KEY=VALUE] [--format text|json|csv]";
+
+// Parses the options in args[first...] into query
+static bool parseOptions(const std::vector<std::string> &args, std::size_t first, SummaryQuery &query,
+                         const std::string &usage, std::string &error)
+{
+    for (std::size_t i = first; i < args.size(); i += 2) {
+        const std::string &option = args[i];
+        if (i + 1 >= args.size()) {
+            error = "Missing value for " + option + ". " + usage;
+            return false;
+        }
+        const std::string &value = args[i + 1];
+
+        if (option == "--from" || option == "--to") {
+            int epoch;
+            if (!parseDateTime(value, epoch)) {
+                error = "Invalid time '" + value + "', expected epoch seconds or \"DD/MM/YY HH:MM\"";
+                return false;
+            }
+            if (option == "--from") {
+                query.hasFrom = true;
+                query.from = epoch;
+            } else {
+                query.hasTo = true;
+                query.to = epoch;
+            }
+        } else if (option == "--last") {
+            long long seconds;
+            if (!parseDuration(value, seconds)) {
+                error = "Invalid duration '" + value + "', expected e.g. 45m, 2h or 7d";
+                return false;
+            }
+            query.hasFrom = true;
+            query.from = static_cast<int>(static_cast<long long>(std::time(nullptr)) - seconds);
+        } else if (option == "--city") {
+            query.city = value;
+        } else if (option == "--event") {
+            query.eventName = value;
+        } else if (option == "--info") {
+            std::string::size_type equals = value.find('=');
+            if (equals == std::string::npos || equals == 0) {
+                error = "Invalid general information filter '" + value + "', expected KEY=VALUE";
+                return false;
+            }
+            query.infoKey = value.substr(0, equals);
+            query.infoValue = value.substr(equals + 1);
+        } else if (option == "--format") {
+            if (value == "text") query.format = SummaryFormat::Text;
+            else if (value == "json") query.format = SummaryFormat::Json;
+            else if (value == "csv") query.format = SummaryFormat::Csv;
+            else {
+                error = "Unknown format '" + value + "', expected text, json or csv";
+                return false;
+            }
+        } else {
+            error = "Unknown option " + option + ". " + usage;
+            return false;
+        }
+    }
+
+    if (query.hasFrom && query.hasTo && query.from > query.to) {
+        error = "Empty time range: --from is after --to";
+        return false;
+    }
+    return true;
+}
+
+bool SummaryQuery::parse(const std::string &line, SummaryQuery &query, std::string &error)
+{
+    const std::string usage = std::string("Usage: summary {channel} {user} {file} ") + OPTIONS_USAGE;
+    std::vector<std::string> args = splitCommandArgs(line);
+    if (args.size() < 4 || args[0] != "summary") {
+        error = usage;
+        return false;
+    }
+
+    query = SummaryQuery();
+    query.channel = args[1];
+    query.user = args[2];
+    query.file = args[3];
+    return parseOptions(args, 4, query, usage, error);
+}
+
+bool SummaryQuery::parseAll(const std::string &line, SummaryQuery &query, std::string &error)
+{
+    const std::string usage = std::string("Usage: summary-all {directory} ") + OPTIONS_USAGE;
+    std::vector<std::string> args = splitCommandArgs(line);
+    if (args.size() < 2 || args[0] != "summary-all") {
+        error = usage;
+        return false;
+    }
+
+    query = SummaryQuery();
+    query.file = args[1];
+    return parseOptions(args, 2, query, usage, error);
+}
+
+bool SummaryQuery::parseHistogram(const std::string &line, SummaryQuery &query, int &bucketSeconds,
+                                  std::string &error)
+{
+    const std::string usage = std::string("Usage: histogram {channel} {user|*} {N{s|m|h|d}} ") + OPTIONS_USAGE;
+    std::vector<std::string> args = splitCommandArgs(line);
+    if (args.size() < 4 || args[0] != "histogram") {
+        error = usage;
+        return false;
+    }
+
+    long long seconds;
+    if (!parseDuration(args[3], seconds) || seconds <= 0 || seconds > INT_MAX) {
+        error = "Invalid bucket width '" + args[3] + "', expected e.g. 15m, 1h or 1d";
+        return false;
+    }
+    bucketSeconds = static_cast<int>(seconds);
+
+    query = SummaryQuery();
+    query.channel = args[1];
+    query.user = args[2] == "*" ? std::string() : args[2];
+    return parseOptions(args, 4, query, usage, error);
+}
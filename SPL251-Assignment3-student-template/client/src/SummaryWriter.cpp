@@ -0,0 +1,290 @@
+#include "../include/SummaryWriter.h"
+#include "../include/DateFormatter.h"
+
+SummaryWriter::SummaryWriter(std::size_t chunkSize) : file_(nullptr), buffer_(), chunkSize_(chunkSize), ok_(true)
+{
+    // Leave some slack so a single report line rarely makes the buffer reallocate
+    buffer_.reserve(chunkSize_ + 4096);
+}
+
+SummaryWriter::~SummaryWriter()
+{
+    close();
+}
+
+bool SummaryWriter::open(const std::string &path)
+{
+    close();
+    file_ = std::fopen(path.c_str(), "wb");
+    if (file_ == nullptr)
+        return false;
+    std::setvbuf(file_, nullptr, _IONBF, 0); // buffer_ already batches the writes
+    ok_ = true;
+    return true;
+}
+
+void SummaryWriter::flushIfFull()
+{
+    if (buffer_.size() >= chunkSize_)
+        flush();
+}
+
+void SummaryWriter::append(const char *data, std::size_t length)
+{
+    // Pieces of a chunk or more (cached reports) skip the copy into the buffer
+    if (length >= chunkSize_ && file_ != nullptr) {
+        flush();
+        if (std::fwrite(data, 1, length, file_) != length)
+            ok_ = false;
+        return;
+    }
+    buffer_.append(data, length);
+    flushIfFull();
+}
+
+void SummaryWriter::append(const std::string &text)
+{
+    append(text.data(), text.size());
+}
+
+void SummaryWriter::append(char ch)
+{
+    buffer_.push_back(ch);
+    flushIfFull();
+}
+
+void SummaryWriter::appendInt(long long value)
+{
+    char digits[24];
+    int pos = sizeof(digits);
+    unsigned long long magnitude = value < 0 ? 0ULL - static_cast<unsigned long long>(value) : value;
+    do {
+        digits[--pos] = static_cast<char>('0' + magnitude % 10);
+        magnitude /= 10;
+    } while (magnitude != 0);
+    if (value < 0)
+        digits[--pos] = '-';
+    append(digits + pos, sizeof(digits) - pos);
+}
+
+void SummaryWriter::appendDate(int epoch)
+{
+    char date[DateFormatter::DATE_LENGTH];
+    append(date, DateFormatter::format(epoch, date));
+}
+
+void SummaryWriter::appendJsonString(const std::string &text)
+{
+    static const char hex[] = "0123456789abcdef";
+    buffer_.push_back('"');
+    for (char ch : text) {
+        switch (ch) {
+            case '"': buffer_.append("\\\""); break;
+            case '\\': buffer_.append("\\\\"); break;
+            case '\n': buffer_.append("\\n"); break;
+            case '\r': buffer_.append("\\r"); break;
+            case '\t': buffer_.append("\\t"); break;
+            default:
+                if (static_cast<unsigned char>(ch) < 0x20) {
+                    buffer_.append("\\u00");
+                    buffer_.push_back(hex[(ch >> 4) & 0xf]);
+                    buffer_.push_back(hex[ch & 0xf]);
+                } else {
+                    buffer_.push_back(ch);
+                }
+        }
+    }
+    buffer_.push_back('"');
+    flushIfFull();
+}
+
+void SummaryWriter::appendCsvField(const std::string &text)
+{
+    if (text.find_first_of(",\"\r\n") == std::string::npos) {
+        append(text);
+        return;
+    }
+    buffer_.push_back('"');
+    for (char ch : text) {
+        if (ch == '"')
+            buffer_.push_back('"');
+        buffer_.push_back(ch);
+    }
+    buffer_.push_back('"');
+    flushIfFull();
+}
+
+std::string SummaryWriter::takeBuffer()
+{
+    std::string taken;
+    taken.swap(buffer_);
+    return taken;
+}
+
+bool SummaryWriter::flush()
+{
+    if (file_ == nullptr)
+        return false;
+    if (!buffer_.empty()) {
+        if (std::fwrite(buffer_.data(), 1, buffer_.size(), file_) != buffer_.size())
+            ok_ = false;
+        buffer_.clear();
+    }
+    return ok_;
+}
+
+bool SummaryWriter::close()
+{
+    if (file_ == nullptr)
+        return ok_;
+    flush();
+    if (std::fclose(file_) != 0)
+        ok_ = false;
+    file_ = nullptr;
+    return ok_;
+}
+
+static bool isFlagSet(const Event &event, const std::string &flag)
+{
+    const std::map<std::string, std::string> &info = event.get_general_information();
+    std::map<std::string, std::string>::const_iterator it = info.find(flag);
+    return it != info.end() && it->second == "true";
+}
+
+void appendSummaryHeader(SummaryWriter &writer, const SummaryQuery &query, const SummaryCounts &counts)
+{
+    switch (query.format) {
+        case SummaryFormat::Json:
+            writer.append("{\"channel\":");
+            writer.appendJsonString(query.channel);
+            writer.append(",\"user\":");
+            writer.appendJsonString(query.user);
+            writer.append(",\"stats\":{\"total\":");
+            writer.appendInt(counts.total);
+            writer.append(",\"active\":");
+            writer.appendInt(counts.active);
+            writer.append(",\"forces_arrival_at_scene\":");
+            writer.appendInt(counts.forcesArrivalAtScene);
+            writer.append("},\"reports\":[");
+            break;
+        case SummaryFormat::Csv:
+            writer.append("report,date_time,date,city,event_name,active,forces_arrival_at_scene,description\n");
+            break;
+        default:
+            writer.append("Channel ");
+            writer.append(query.channel);
+            writer.append("\nStates:\nTotal: ");
+            writer.appendInt(counts.total);
+            writer.append("\nactive: ");
+            writer.appendInt(counts.active);
+            writer.append("\nforces_arrival_at_scene: ");
+            writer.appendInt(counts.forcesArrivalAtScene);
+            writer.append("\nEvent Reports:\n");
+    }
+}
+
+static void writeTextReports(SummaryWriter &writer, const std::vector<const Event *> &events, long long firstReport)
+{
+    long long the_num_of_report = firstReport;
+    for (const Event *event : events) {
+        writer.append("Report_");
+        writer.appendInt(the_num_of_report++);
+        writer.append(":\ncity: ");
+        writer.append(event->get_city());
+        writer.append("\ndate time: ");
+        writer.appendDate(event->get_date_time());
+        writer.append("\nevent name: ");
+        writer.append(event->get_name());
+        writer.append("\nsummary: ");
+        const std::string &description = event->get_description();
+        if (description.length() > 27) {
+            writer.append(description.data(), 27);
+            writer.append("...");
+        } else {
+            writer.append(description);
+        }
+        writer.append('\n');
+    }
+}
+
+static void writeJsonReports(SummaryWriter &writer, const std::vector<const Event *> &events, long long firstReport)
+{
+    bool firstEvent = firstReport == 1;
+    for (const Event *event : events) {
+        writer.append(firstEvent ? "\n{\"city\":" : ",\n{\"city\":");
+        firstEvent = false;
+        writer.appendJsonString(event->get_city());
+        writer.append(",\"date_time\":");
+        writer.appendInt(event->get_date_time());
+        writer.append(",\"date\":\"");
+        writer.appendDate(event->get_date_time());
+        writer.append("\",\"event_name\":");
+        writer.appendJsonString(event->get_name());
+        writer.append(",\"description\":");
+        writer.appendJsonString(event->get_description());
+        writer.append(",\"general_information\":{");
+        bool firstInfo = true;
+        for (const auto &info : event->get_general_information()) {
+            if (!firstInfo)
+                writer.append(',');
+            firstInfo = false;
+            writer.appendJsonString(info.first);
+            writer.append(':');
+            writer.appendJsonString(info.second);
+        }
+        writer.append("}}");
+    }
+}
+
+static void writeCsvReports(SummaryWriter &writer, const std::vector<const Event *> &events, long long firstReport)
+{
+    long long the_num_of_report = firstReport;
+    for (const Event *event : events) {
+        writer.appendInt(the_num_of_report++);
+        writer.append(',');
+        writer.appendInt(event->get_date_time());
+        writer.append(',');
+        writer.appendDate(event->get_date_time());
+        writer.append(',');
+        writer.appendCsvField(event->get_city());
+        writer.append(',');
+        writer.appendCsvField(event->get_name());
+        writer.append(isFlagSet(*event, "active") ? ",true" : ",false");
+        writer.append(isFlagSet(*event, "forces_arrival_at_scene") ? ",true," : ",false,");
+        writer.appendCsvField(event->get_description());
+        writer.append('\n');
+    }
+}
+
+void appendSummaryReports(SummaryWriter &writer, const SummaryQuery &query, const std::vector<const Event *> &events,
+                          long long firstReport)
+{
+    switch (query.format) {
+        case SummaryFormat::Json:
+            writeJsonReports(writer, events, firstReport);
+            break;
+        case SummaryFormat::Csv:
+            writeCsvReports(writer, events, firstReport);
+            break;
+        default:
+            writeTextReports(writer, events, firstReport);
+    }
+}
+
+void appendSummaryTrailer(SummaryWriter &writer, const SummaryQuery &query)
+{
+    if (query.format == SummaryFormat::Json)
+        writer.append("\n]}\n");
+}
+
+bool writeSummary(const SummaryQuery &query, const std::vector<const Event *> &events, const SummaryCounts &counts)
+{
+    // One writer per thread, so its chunk buffer is allocated once and reused by every summary
+    static thread_local SummaryWriter writer;
+    if (!writer.open(query.file))
+        return false;
+    appendSummaryHeader(writer, query, counts);
+    appendSummaryReports(writer, query, events, 1);
+    appendSummaryTrailer(writer, query);
+    return writer.close();
+}
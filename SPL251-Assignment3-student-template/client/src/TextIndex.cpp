@@ -0,0 +1,296 @@
+#include "../include/TextIndex.h"
+#include <algorithm>
+#include <cmath>
+
+TextIndex::TextIndex() : termIds_(), postings_(), docLengths_(), docCount_(0), totalLength_(0) {}
+
+static bool isWordByte(unsigned char ch)
+{
+    return (ch >= '0' && ch <= '9') || (ch >= 'a' && ch <= 'z') || (ch >= 'A' && ch <= 'Z') || ch >= 0x80;
+}
+
+std::vector<std::string> TextIndex::tokenize(const std::string &text)
+{
+    std::vector<std::string> words;
+    std::string word;
+    for (char ch : text) {
+        unsigned char byte = static_cast<unsigned char>(ch);
+        if (isWordByte(byte)) {
+            word.push_back(byte >= 'A' && byte <= 'Z' ? static_cast<char>(byte - 'A' + 'a') : ch);
+        } else if (!word.empty()) {
+            words.push_back(word);
+            word.clear();
+        }
+    }
+    if (!word.empty())
+        words.push_back(word);
+    return words;
+}
+
+void TextIndex::add(DocId doc, const std::string &text)
+{
+    std::vector<std::string> words = tokenize(text);
+    std::size_t length = std::min<std::size_t>(words.size(), UINT16_MAX);
+    if (docLengths_.size() <= doc)
+        docLengths_.resize(doc + 1, 0);
+    docLengths_[doc] = static_cast<std::uint16_t>(length);
+    ++docCount_;
+    totalLength_ += length;
+
+    for (std::size_t position = 0; position < length; ++position) {
+        std::pair<std::unordered_map<std::string, std::uint32_t>::iterator, bool> term =
+            termIds_.insert(std::make_pair(words[position], static_cast<std::uint32_t>(postings_.size())));
+        if (term.second)
+            postings_.push_back(Postings());
+        Postings &postings = postings_[term.first->second];
+        if (postings.docs.empty() || postings.docs.back() != doc) {
+            postings.docs.push_back(doc);
+            postings.offsets.push_back(static_cast<std::uint32_t>(postings.positions.size()));
+        }
+        postings.positions.push_back(static_cast<std::uint16_t>(position));
+    }
+}
+
+void TextIndex::append(const TextIndex &other, DocId offset)
+{
+    if (docLengths_.size() < offset + other.docLengths_.size())
+        docLengths_.resize(offset + other.docLengths_.size(), 0);
+    std::copy(other.docLengths_.begin(), other.docLengths_.end(), docLengths_.begin() + offset);
+    docCount_ += other.docCount_;
+    totalLength_ += other.totalLength_;
+
+    for (const auto &term : other.termIds_) {
+        std::pair<std::unordered_map<std::string, std::uint32_t>::iterator, bool> entry =
+            termIds_.insert(std::make_pair(term.first, static_cast<std::uint32_t>(postings_.size())));
+        if (entry.second)
+            postings_.push_back(Postings());
+        Postings &target = postings_[entry.first->second];
+        const Postings &source = other.postings_[term.second];
+        std::uint32_t base = static_cast<std::uint32_t>(target.positions.size());
+        for (DocId doc : source.docs)
+            target.docs.push_back(doc + offset);
+        for (std::uint32_t position : source.offsets)
+            target.offsets.push_back(position + base);
+        target.positions.insert(target.positions.end(), source.positions.begin(), source.positions.end());
+    }
+}
+
+void TextIndex::clear()
+{
+    termIds_.clear();
+    postings_.clear();
+    docLengths_.clear();
+    docCount_ = 0;
+    totalLength_ = 0;
+}
+
+std::size_t TextIndex::memoryBytes() const
+{
+    std::size_t bytes = docLengths_.capacity() * sizeof(std::uint16_t) + postings_.capacity() * sizeof(Postings);
+    bytes += termIds_.bucket_count() * sizeof(void *);
+    for (const auto &term : termIds_)
+        bytes += sizeof(void *) * 2 + sizeof(std::string) + sizeof(std::uint32_t) + term.first.capacity();
+    for (const Postings &postings : postings_) {
+        bytes += postings.docs.capacity() * sizeof(DocId) + postings.offsets.capacity() * sizeof(std::uint32_t) +
+                 postings.positions.capacity() * sizeof(std::uint16_t);
+    }
+    return bytes;
+}
+
+// Positions of the cursor-th document of postings, as a [first, last) range
+static void positionRange(const std::vector<std::uint32_t> &offsets, std::size_t positionsSize, std::size_t index,
+                          std::uint32_t &first, std::uint32_t &last)
+{
+    first = offsets[index];
+    last = index + 1 < offsets.size() ? offsets[index + 1] : static_cast<std::uint32_t>(positionsSize);
+}
+
+std::uint32_t TextIndex::phraseFrequency(const Clause &clause, const std::vector<const Postings *> &lists,
+                                         const std::vector<std::size_t> &cursors)
+{
+    const Postings &head = *lists[clause[0]];
+    std::uint32_t first, last;
+    positionRange(head.offsets, head.positions.size(), cursors[clause[0]], first, last);
+    if (clause.size() == 1)
+        return last - first;
+
+    std::uint32_t matches = 0;
+    for (std::uint32_t p = first; p < last; ++p) {
+        std::uint32_t start = head.positions[p];
+        bool match = true;
+        for (std::size_t k = 1; k < clause.size() && match; ++k) {
+            const Postings &next = *lists[clause[k]];
+            std::uint32_t nextFirst, nextLast;
+            positionRange(next.offsets, next.positions.size(), cursors[clause[k]], nextFirst, nextLast);
+            match = std::binary_search(next.positions.begin() + nextFirst, next.positions.begin() + nextLast,
+                                       static_cast<std::uint16_t>(start + k));
+        }
+        if (match)
+            ++matches;
+    }
+    return matches;
+}
+
+static bool betterHit(const TextIndex::Hit &a, const TextIndex::Hit &b)
+{
+    if (a.score != b.score)
+        return a.score > b.score;
+    return a.doc > b.doc; // newer first on ties
+}
+
+std::vector<std::vector<std::string>> TextIndex::parseQuery(const std::string &query)
+{
+    std::vector<std::vector<std::string>> clauses;
+    std::string current;
+    bool inQuotes = false;
+    for (char ch : query + '"') {
+        if (ch != '"') {
+            current.push_back(ch);
+            continue;
+        }
+        std::vector<std::string> words = tokenize(current);
+        if (inQuotes) {
+            if (!words.empty())
+                clauses.push_back(words);
+        } else {
+            for (const std::string &word : words)
+                clauses.push_back(std::vector<std::string>(1, word));
+        }
+        current.clear();
+        inQuotes = !inQuotes;
+    }
+    return clauses;
+}
+
+void TextIndex::addStats(const std::string &query, CorpusStats &stats) const
+{
+    addStats(parseQuery(query), stats);
+}
+
+void TextIndex::addStats(const std::vector<std::vector<std::string>> &query, CorpusStats &stats) const
+{
+    stats.docCount += docCount_;
+    stats.totalLength += totalLength_;
+    std::vector<std::string> words;
+    for (const std::vector<std::string> &clause : query)
+        words.insert(words.end(), clause.begin(), clause.end());
+    std::sort(words.begin(), words.end());
+    words.erase(std::unique(words.begin(), words.end()), words.end());
+    for (const std::string &word : words) {
+        std::size_t &frequency = stats.documentFrequency[word];
+        std::unordered_map<std::string, std::uint32_t>::const_iterator term = termIds_.find(word);
+        if (term != termIds_.end())
+            frequency += postings_[term->second].docs.size();
+    }
+}
+
+std::vector<TextIndex::Hit> TextIndex::search(const std::string &query, std::size_t limit,
+                                              const CorpusStats *stats) const
+{
+    return search(parseQuery(query), limit, stats);
+}
+
+std::vector<TextIndex::Hit> TextIndex::search(const std::vector<std::vector<std::string>> &words, std::size_t limit,
+                                              const CorpusStats *stats) const
+{
+    std::vector<Hit> hits;
+    if (limit == 0 || docCount_ == 0)
+        return hits;
+
+    std::vector<const Postings *> lists; // distinct term lists, shared by clauses
+    std::vector<Clause> clauses;
+    std::vector<std::size_t> clauseFrequency; // documents containing the rarest word of each clause
+    for (const std::vector<std::string> &clauseWords : words) {
+        Clause clause;
+        std::size_t frequency = 0;
+        for (const std::string &word : clauseWords) {
+            std::unordered_map<std::string, std::uint32_t>::const_iterator term = termIds_.find(word);
+            if (term == termIds_.end())
+                return hits; // every clause is required, an unknown word matches nothing
+            const Postings *postings = &postings_[term->second];
+            std::vector<const Postings *>::iterator existing = std::find(lists.begin(), lists.end(), postings);
+            clause.push_back(existing - lists.begin());
+            if (existing == lists.end())
+                lists.push_back(postings);
+
+            std::size_t wordFrequency = postings->docs.size();
+            if (stats != nullptr) {
+                std::unordered_map<std::string, std::size_t>::const_iterator known = stats->documentFrequency.find(word);
+                if (known != stats->documentFrequency.end())
+                    wordFrequency = known->second;
+            }
+            if (clause.size() == 1 || wordFrequency < frequency)
+                frequency = wordFrequency; // a phrase is at most as common as its rarest word
+        }
+        clauses.push_back(clause);
+        clauseFrequency.push_back(frequency);
+    }
+    if (clauses.empty())
+        return hits;
+
+    // Walk the rarest list and gallop the others forward to each of its documents
+    std::size_t driver = 0;
+    for (std::size_t i = 1; i < lists.size(); ++i) {
+        if (lists[i]->docs.size() < lists[driver]->docs.size())
+            driver = i;
+    }
+
+    const double k1 = 1.2, b = 0.75;
+    std::size_t docCount = stats != nullptr ? stats->docCount : docCount_;
+    unsigned long long totalLength = stats != nullptr ? stats->totalLength : totalLength_;
+    const double averageLength = docCount != 0 ? double(totalLength) / docCount : 1.0;
+    std::vector<double> idf(clauses.size());
+    for (std::size_t c = 0; c < clauses.size(); ++c) {
+        double documentFrequency = static_cast<double>(clauseFrequency[c]);
+        idf[c] = std::log(1.0 + (docCount - documentFrequency + 0.5) / (documentFrequency + 0.5));
+    }
+
+    std::vector<std::size_t> cursors(lists.size(), 0);
+    const std::vector<DocId> &driverDocs = lists[driver]->docs;
+    for (std::size_t d = 0; d < driverDocs.size(); ++d) {
+        DocId doc = driverDocs[d];
+        cursors[driver] = d;
+        bool inAll = true;
+        for (std::size_t i = 0; i < lists.size() && inAll; ++i) {
+            if (i == driver)
+                continue;
+            const std::vector<DocId> &docs = lists[i]->docs;
+            std::size_t low = cursors[i], step = 1;
+            while (low + step < docs.size() && docs[low + step] < doc) {
+                low += step;
+                step *= 2;
+            }
+            std::size_t high = std::min(low + step + 1, docs.size());
+            cursors[i] = std::lower_bound(docs.begin() + low, docs.begin() + high, doc) - docs.begin();
+            inAll = cursors[i] < docs.size() && docs[cursors[i]] == doc;
+        }
+        if (!inAll)
+            continue;
+
+        double score = 0;
+        double lengthNorm = k1 * (1 - b + b * docLengths_[doc] / averageLength);
+        for (std::size_t c = 0; c < clauses.size(); ++c) {
+            std::uint32_t frequency = phraseFrequency(clauses[c], lists, cursors);
+            if (frequency == 0) {
+                score = -1;
+                break;
+            }
+            score += idf[c] * frequency * (k1 + 1) / (frequency + lengthNorm);
+        }
+        if (score < 0)
+            continue;
+
+        // Keep the best `limit` hits in a heap whose front is the weakest
+        Hit hit = {doc, score};
+        if (hits.size() < limit) {
+            hits.push_back(hit);
+            std::push_heap(hits.begin(), hits.end(), betterHit);
+        } else if (betterHit(hit, hits.front())) {
+            std::pop_heap(hits.begin(), hits.end(), betterHit);
+            hits.back() = hit;
+            std::push_heap(hits.begin(), hits.end(), betterHit);
+        }
+    }
+    std::sort_heap(hits.begin(), hits.end(), betterHit);
+    return hits;
+}
@@ -1,4 +1,5 @@
 #include "../include/event.h"
+#include "../include/Hash.h"
 #include "../include/json.hpp"
 #include <iostream>
 #include <fstream>
@@ -16,8 +17,10 @@ using json = nlohmann::json;
 Event::Event(std::string channel_name, std::string city, std::string name, int date_time,
              std::string description, std::map<std::string, std::string> general_information)
     : channel_name(channel_name), city(city), name(name),
-      date_time(date_time), description(description), general_information(general_information), eventOwnerUser("")
+      date_time(date_time), description(description), general_information(general_information), eventOwnerUser(""),
+      content_hash(0)
 {
+    update_content_hash();
 }
 
 Event::~Event()
@@ -26,6 +29,35 @@ Event::~Event()
 
 void Event::setEventOwnerUser(std::string setEventOwnerUser) {
     eventOwnerUser = setEventOwnerUser;
+    update_content_hash();
+}
+
+// Each field is hashed with its length so that moving text between fields changes the hash
+static std::uint64_t hash_field(std::uint64_t hash, const std::string &field)
+{
+    std::uint64_t length = field.size();
+    hash = fnv1a64(reinterpret_cast<const char *>(&length), sizeof(length), hash);
+    return fnv1a64(field.data(), field.size(), hash);
+}
+
+void Event::update_content_hash()
+{
+    std::uint64_t hash = hash_field(fnv1a64(nullptr, 0), channel_name);
+    hash = hash_field(hash, eventOwnerUser);
+    hash = hash_field(hash, city);
+    hash = hash_field(hash, name);
+    hash = fnv1a64(reinterpret_cast<const char *>(&date_time), sizeof(date_time), hash);
+    hash = hash_field(hash, description);
+    for (const auto &info : general_information) {
+        hash = hash_field(hash, info.first);
+        hash = hash_field(hash, info.second);
+    }
+    content_hash = mix64(hash);
+}
+
+std::uint64_t Event::get_content_hash() const
+{
+    return content_hash;
 }
 
 const std::string &Event::getEventOwnerUser() const {
@@ -64,7 +96,7 @@ const std::string &Event::get_description() const
 
 Event::Event(const std::string &frame_body): channel_name(""), city(""), 
                                              name(""), date_time(0), description(""), general_information(),
-                                             eventOwnerUser("")
+                                             eventOwnerUser(""), content_hash(0)
 {
     stringstream ss(frame_body);
     string line;
@@ -110,6 +142,7 @@ Event::Event(const std::string &frame_body): channel_name(""), city(""),
         }
     }
     general_information = general_information_from_string;
+    update_content_hash();
 }
 
 names_and_events parseEventsFile(std::string json_path)
@@ -149,7 +149,7 @@ public class StompMessagingProtocolImpl  implements StompMessagingProtocol<Stomp
         }
 
         if (connections.isSubscribed(connectionId, topic)) {
-            sendMessageFrame(topic, body);
+            sendMessageFrame(topic, body, frame.getHeaders());
             String receipt = frame.getHeader("receipt");
             if (receipt != null) {
                 sendReceiptFrame(receipt);
@@ -180,9 +180,15 @@ public class StompMessagingProtocolImpl  implements StompMessagingProtocol<Stomp
         connections.send(connectionId, errorFrame);
     }
 
-    private void sendMessageFrame(String topic, String detailedMessage) {
+    private void sendMessageFrame(String topic, String detailedMessage, Map<String, String> sendHeaders) {
         System.out.println("in StompMessagingProtocolImpl: sendMessageFrame");
         Map<String, String> headers = new ConcurrentHashMap<>();
+        // User-defined SEND headers (e.g. the client's sent-at and sequence) travel with the message, as STOMP 1.2 specifies
+        for (Map.Entry<String, String> header : sendHeaders.entrySet()) {
+            if (!header.getKey().equals("receipt") && !header.getKey().equals("content-length")) {
+                headers.put(header.getKey(), header.getValue());
+            }
+        }
         headers.put("destination", topic);
         headers.put("message-id", "" + messageIdCounter.getAndIncrement());
         detailedMessage = "user: " + username + "\nchannel name: " + topic + "\n" + detailedMessage;
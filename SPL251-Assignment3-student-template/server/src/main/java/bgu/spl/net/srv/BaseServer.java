@@ -41,6 +41,7 @@ public abstract class BaseServer implements Server {
 
             while (!Thread.currentThread().isInterrupted()) {
                 Socket clientSock = serverSock.accept();
+                clientSock.setTcpNoDelay(true); // each frame is one write; Nagle would delay the next one ~40ms
                 StompMessagingProtocol<StompFrame> protocol = protocolFactory.get();
                 BlockingConnectionHandler handler = new BlockingConnectionHandler(
                     clientSock,
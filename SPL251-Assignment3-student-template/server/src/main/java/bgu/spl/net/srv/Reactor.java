@@ -100,6 +100,7 @@ public class Reactor implements Server {
     private void handleAccept(ServerSocketChannel serverChan, Selector selector) throws IOException {
         SocketChannel clientChan = serverChan.accept();
         clientChan.configureBlocking(false);
+        clientChan.socket().setTcpNoDelay(true); // each frame is one write; Nagle would delay the next one ~40ms
         StompMessagingProtocol<StompFrame> protocol = protocolFactory.get();
         final NonBlockingConnectionHandler handler = new NonBlockingConnectionHandler(
                 readerFactory.get(),